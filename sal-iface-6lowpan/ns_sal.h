@@ -16,8 +16,279 @@
 #ifndef _NS_SAL_H_
 #define _NS_SAL_H_
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * NanoStack specific socket options, used with socket_api set_option() and
+ * get_option(). Protocol level is not checked for these options.
+ * Values are kept below 0x100 so that they fit to a short enum.
+ */
+#define NS_SAL_OPT_RCVBUF           ((socket_option_type_t) 0x80) /*<! uint32_t, receive queue limit in bytes, 0 = no limit */
+#define NS_SAL_OPT_RCVBUF_POLICY    ((socket_option_type_t) 0x81) /*<! uint8_t, ns_sal_rcvbuf_policy_t */
+#define NS_SAL_OPT_RX_DROPPED       ((socket_option_type_t) 0x82) /*<! uint32_t, get only, datagrams dropped due to receive queue limit */
+#define NS_SAL_OPT_RX_COALESCE      ((socket_option_type_t) 0x83) /*<! uint8_t, SOCKET_STREAM only, 1 = append small segments to previous receive buffer */
+#define NS_SAL_OPT_RX_DIRECT        ((socket_option_type_t) 0x84) /*<! uint8_t, 1 = leave received data to NanoStack until read */
+#define NS_SAL_OPT_RX_QUEUED        ((socket_option_type_t) 0x85) /*<! struct ns_sal_rx_queued, get only, received data waiting to be read */
+#define NS_SAL_OPT_RX_PEEK          ((socket_option_type_t) 0x86) /*<! struct ns_sal_rx_peek, get only, copy received data without removing it */
+#define NS_SAL_OPT_RX_NOTIFY        ((socket_option_type_t) 0x87) /*<! uint8_t, ns_sal_rx_notify_t */
+#define NS_SAL_OPT_RX_OVERRUN       ((socket_option_type_t) 0x88) /*<! uint32_t, get only, received data lost due to lack of memory */
+#define NS_SAL_OPT_SNDQUEUE         ((socket_option_type_t) 0x89) /*<! uint32_t, transmit queue limit in bytes, 0 = no queue */
+#define NS_SAL_OPT_TX_QUEUE_STATS   ((socket_option_type_t) 0x8A) /*<! struct ns_sal_tx_queue_stats, get only */
+#define NS_SAL_OPT_CORK             ((socket_option_type_t) 0x8B) /*<! uint8_t, SOCKET_STREAM only, 1 = hold small writes until segment is full, 0 = send held data */
+#define NS_SAL_OPT_NODELAY          ((socket_option_type_t) 0x8C) /*<! uint8_t, SOCKET_STREAM only, 1 = send writes immediately (default), 0 = coalesce small writes while previous send is in progress */
+#define NS_SAL_OPT_SNDBUF           ((socket_option_type_t) 0x8D) /*<! uint32_t, send buffer size in bytes, used for NS_SAL_OPT_SNDSPACE */
+#define NS_SAL_OPT_SNDSPACE         ((socket_option_type_t) 0x8E) /*<! struct ns_sal_tx_space, get only */
+#define NS_SAL_OPT_PACING           ((socket_option_type_t) 0x8F) /*<! struct ns_sal_pacing, SOCKET_DGRAM only */
+#define NS_SAL_OPT_TCLASS           ((socket_option_type_t) 0x90) /*<! uint8_t, IPv6 traffic class of sent packets, DSCP in 6 high bits */
+#define NS_SAL_OPT_FLOW_LABEL       ((socket_option_type_t) 0x91) /*<! uint32_t, IPv6 flow label of sent packets, 20 bits */
+#define NS_SAL_OPT_PRIORITY         ((socket_option_type_t) 0x92) /*<! uint8_t, transmit priority 0 (default) - NS_SAL_PRIORITY_MAX */
+#define NS_SAL_OPT_EVENT_MASK       ((socket_option_type_t) 0x93) /*<! uint32_t, events delivered to socket handler, NS_SAL_EVENT_BIT() */
+
+/*
+ * Highest transmit priority, NS_SAL_OPT_PRIORITY. Sockets are served in strict
+ * priority order: data of a socket is held in the transmit queue while a socket
+ * with higher priority has data queued or in flight. Data in flight stops holding
+ * other sockets when the higher priority socket is closed, destroyed or its
+ * connection is closed. Held data is limited by NS_SAL_OPT_SNDQUEUE, or by
+ * NS_SAL_OPT_SNDBUF if queue limit is not set.
+ */
+#define NS_SAL_PRIORITY_MAX         7
+
+/*
+ * Event subscription mask bits, NS_SAL_OPT_EVENT_MASK. Socket handler is called
+ * only for events with the bit set, all events are delivered by default.
+ * Socket state is updated also for unsubscribed events, for example received
+ * data is queued and can be read when application polls the socket.
+ */
+#define NS_SAL_EVENT_BIT(event)     (1UL << (event))
+#define NS_SAL_EVENT_MASK_ALL       0xffffffffUL
+
+/*
+ * Receive overrun is reported with SOCKET_EVENT_RX_ERROR and error SOCKET_ERROR_BAD_ALLOC.
+ * Received data is lost and application should resynchronize with the peer.
+ */
+
+/*
+ * Action taken when a received datagram does not fit to the receive queue limit.
+ * Stream data is never dropped, data over the limit is left to NanoStack until
+ * the application reads it.
+ */
+typedef enum {
+    NS_SAL_RCVBUF_DROP_NEWEST = 0,  /*<! drop received data */
+    NS_SAL_RCVBUF_DROP_OLDEST,      /*<! drop oldest queued data until received data fits */
+    NS_SAL_RCVBUF_REJECT,           /*<! drop received data and send SOCKET_EVENT_RX_ERROR */
+} ns_sal_rcvbuf_policy_t;
+
+/*
+ * When SOCKET_EVENT_RX_DONE is sent to application.
+ */
+typedef enum {
+    NS_SAL_RX_NOTIFY_ALL = 0,       /*<! every time data is received */
+    NS_SAL_RX_NOTIFY_EDGE,          /*<! only when all earlier data has been read, application must
+                                         read until SOCKET_ERROR_WOULD_BLOCK to get next event.
+                                         Use NS_SAL_OPT_RX_QUEUED to find amount of queued data. */
+} ns_sal_rx_notify_t;
+
+/*
+ * Received data waiting to be read, NS_SAL_OPT_RX_QUEUED.
+ * Data left to NanoStack in NS_SAL_OPT_RX_DIRECT mode is not included.
+ */
+struct ns_sal_rx_queued {
+    uint32_t bytes;             /*<! number of bytes waiting to be read */
+    uint16_t count;             /*<! number of receive buffers (datagrams) */
+    uint16_t next_len;          /*<! length of next datagram or stream buffer, 0 if none */
+};
+
+/*
+ * Peek buffer, NS_SAL_OPT_RX_PEEK. Next datagram, or stream data up to len bytes,
+ * is copied to buf and len is set to number of bytes copied.
+ * Data left to NanoStack in NS_SAL_OPT_RX_DIRECT mode can't be peeked.
+ */
+struct ns_sal_rx_peek {
+    void *buf;                  /*<! data buffer */
+    size_t len;                 /*<! buffer size, set to number of bytes copied */
+    struct socket_addr addr;    /*<! sender address of the first buffer */
+    uint16_t port;              /*<! sender port of the first buffer */
+};
+
+/*
+ * Transmit queue statistics, NS_SAL_OPT_TX_QUEUE_STATS.
+ * Data is queued when NanoStack is busy sending previous data and sent when
+ * NanoStack reports previous send done or failed. SOCKET_EVENT_TX_DONE and
+ * SOCKET_EVENT_TX_ERROR are delivered after queued data is passed to NanoStack,
+ * so application can retry send that returned SOCKET_ERROR_BUSY on these events.
+ */
+struct ns_sal_tx_queue_stats {
+    uint32_t bytes;             /*<! number of bytes in queue */
+    uint16_t count;             /*<! number of sends in queue */
+    uint16_t max_count;         /*<! highest number of sends in queue */
+    uint32_t queued;            /*<! number of sends queued since socket creation */
+    uint32_t latency_last_us;   /*<! time last sent data waited in queue */
+    uint32_t latency_max_us;    /*<! longest time data waited in queue */
+};
+
+/*
+ * Send buffer usage, NS_SAL_OPT_SNDSPACE. Data is in flight from the time NanoStack
+ * accepts it until NanoStack reports it sent with SOCKET_EVENT_TX_DONE, or send failed.
+ * Application can write up to free bytes without overrunning the send buffer.
+ * Sends are not refused when the send buffer is full.
+ */
+struct ns_sal_tx_space {
+    uint32_t in_flight;         /*<! bytes accepted by NanoStack and not yet sent */
+    uint32_t queued;            /*<! bytes held in SAL transmit queue and coalescing buffer */
+    uint32_t free;              /*<! NS_SAL_OPT_SNDBUF minus in_flight and queued, 0 if full */
+};
+
+/*
+ * Transmit pacing, NS_SAL_OPT_PACING. Datagrams are passed to NanoStack at most
+ * rate bytes per second on average, and at most burst bytes back-to-back.
+ * Datagrams exceeding the rate are held in the transmit queue and released from
+ * the SAL transmit timer. Queue is limited by NS_SAL_OPT_SNDQUEUE, or by
+ * NS_SAL_OPT_SNDBUF if queue limit is not set; send returns SOCKET_ERROR_BUSY
+ * when the queue is full. Datagram larger than burst is sent when bucket is full.
+ */
+struct ns_sal_pacing {
+    uint32_t rate;              /*<! bytes per second, 0 = pacing disabled (default) */
+    uint32_t burst;             /*<! bucket size in bytes, must not be 0 if rate is set */
+};
+
+/*
+ * Datagram descriptor for batch functions.
+ */
+struct ns_sal_datagram {
+    void *buf;                  /*<! data buffer */
+    size_t len;                 /*<! buffer size, set to datagram length on receive */
+    struct socket_addr addr;    /*<! remote address */
+    uint16_t port;              /*<! remote port */
+};
+
+/*
+ * Scatter/gather element for send functions.
+ */
+struct ns_sal_iovec {
+    const void *base;           /*<! data */
+    size_t len;                 /*<! data length */
+};
+
+/*
+ * Handle of application owned transmit buffer, see tx_alloc().
+ */
+typedef struct _tx_buff_t *ns_sal_tx_handle_t;
+
+/*
+ * NanoStack specific socket API extensions. These functions are used with sockets
+ * created through nanostack socket_api table.
+ */
+struct ns_sal_socket_api_ext {
+    /*
+     * \brief Borrow first received buffer without copying it. Data stays valid
+     * until recv_release() or socket destroy. Other receive functions return
+     * SOCKET_ERROR_BUSY while data is borrowed.
+     * \param socket socket to read
+     * \param data pointer to received data is stored here
+     * \param len length of received data is stored here
+     * \param addr sender address is stored here, can be NULL
+     * \param port sender port is stored here, can be NULL
+     */
+    socket_error_t (*recv_borrow)(struct socket *socket, const uint8_t **data, size_t *len,
+                                  struct socket_addr *addr, uint16_t *port);
+    /*
+     * \brief Release data borrowed with recv_borrow()
+     * \param socket socket to release data from
+     */
+    socket_error_t (*recv_release)(struct socket *socket);
+    /*
+     * \brief Receive multiple datagrams with one call. Datagrams that don't fit
+     * to the descriptor buffer are truncated like in recv_from().
+     * \param socket SOCKET_DGRAM socket to read
+     * \param dgrams array of datagram descriptors to fill
+     * \param count number of descriptors in array, set to number of received datagrams
+     */
+    socket_error_t (*recv_from_batch)(struct socket *socket, struct ns_sal_datagram *dgrams, size_t *count);
+    /*
+     * \brief Send data gathered from multiple buffers, like send(). Buffers are
+     * sent as one datagram or as continuous stream data. Data is copied once,
+     * to a transmit buffer that is also queued as is if NanoStack is busy.
+     * Stream data held by NS_SAL_OPT_CORK or NS_SAL_OPT_NODELAY is sent first.
+     * While NS_SAL_OPT_CORK is set, gathered data shorter than a segment is
+     * held with it.
+     * \param socket socket to send to
+     * \param iov array of buffers to send
+     * \param iovcnt number of buffers in array
+     */
+    socket_error_t (*sendv)(struct socket *socket, const struct ns_sal_iovec *iov, size_t iovcnt);
+    /*
+     * \brief Send datagram gathered from multiple buffers, like send_to().
+     * \param socket SOCKET_DGRAM socket to send to
+     * \param iov array of buffers to send
+     * \param iovcnt number of buffers in array
+     * \param addr destination address
+     * \param port destination port
+     */
+    socket_error_t (*sendv_to)(struct socket *socket, const struct ns_sal_iovec *iov, size_t iovcnt,
+                               const struct socket_addr *addr, const uint16_t port);
+    /*
+     * \brief Send multiple datagrams, to one or more destinations, with one call.
+     * Datagrams are sent in array order. If NanoStack is busy and transmit queue
+     * (NS_SAL_OPT_SNDQUEUE) is full, rest of the datagrams get SOCKET_ERROR_BUSY.
+     * \param socket SOCKET_DGRAM socket to send to
+     * \param dgrams array of datagrams, buf, len, addr and port must be set
+     * \param status send status of each datagram is stored here
+     * \param count number of datagrams in array
+     * \return SOCKET_ERROR_NONE if all datagrams were sent, otherwise first error
+     */
+    socket_error_t (*send_to_batch)(struct socket *socket, const struct ns_sal_datagram *dgrams,
+                                    socket_error_t *status, size_t count);
+    /*
+     * \brief Allocate transmit buffer owned by application. Data is written
+     * directly to the buffer and sent with send_buffer().
+     * \param size buffer size
+     * \param data pointer to buffer data is stored here
+     * \return buffer handle, NULL on failure
+     */
+    ns_sal_tx_handle_t (*tx_alloc)(size_t size, uint8_t **data);
+    /*
+     * \brief Free transmit buffer. Buffer must be owned by application.
+     * \param handle buffer handle
+     */
+    void (*tx_free)(ns_sal_tx_handle_t handle);
+    /*
+     * \brief Send transmit buffer. On success buffer ownership passes to socket
+     * and buffer is not copied if NanoStack is busy. Buffer is returned by
+     * tx_reclaim() after SOCKET_EVENT_TX_DONE or SOCKET_EVENT_TX_ERROR for it.
+     * While NS_SAL_OPT_CORK is set, stream data shorter than a segment is
+     * copied and held, and the buffer is returned after earlier sends complete.
+     * Buffers are freed if socket is destroyed before they are reclaimed.
+     * If NanoStack is busy and transmit queue (NS_SAL_OPT_SNDQUEUE) is disabled
+     * or full, SOCKET_ERROR_BUSY is returned and application keeps the buffer.
+     * \param socket socket to send to
+     * \param handle buffer handle
+     * \param len data length
+     * \param addr destination address, NULL for connected socket
+     * \param port destination port
+     */
+    socket_error_t (*send_buffer)(struct socket *socket, ns_sal_tx_handle_t handle, size_t len,
+                                  const struct socket_addr *addr, const uint16_t port);
+    /*
+     * \brief Take back ownership of a sent buffer. Buffers are returned in send order.
+     * \param socket socket that sent the buffer
+     * \param handle buffer handle is stored here
+     * \param status send result is stored here, can be NULL
+     * \return SOCKET_ERROR_WOULD_BLOCK if no buffer has completed
+     */
+    socket_error_t (*tx_reclaim)(struct socket *socket, ns_sal_tx_handle_t *handle, socket_error_t *status);
+};
+
+extern const struct ns_sal_socket_api_ext nanostack_socket_api_ext;
+
 /*
  * \brief Initialize NanoStack Socket Abstraction layer.
  */
-uint8_t ns_sal_init_stack(void);
+socket_error_t ns_sal_init_stack(void);
+
+#ifdef __cplusplus
+}
+#endif
 #endif /* _NS_SAL_H_ */
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2015 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _NS_SAL_BUFFER_H_
+#define _NS_SAL_BUFFER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Buffer for the received datagram.
+ * Every socket will contain received data in a receive queue.
+ */
+typedef struct _data_buff_t {
+    struct _data_buff_t *next;  /*<! next buffer */
+    ns_address_t ns_address;    /*<! address where data is received */
+    uint16_t length;            /*<! unread data length in this buffer */
+    uint16_t offset;            /*<! offset of unread data in payload */
+    uint16_t size;              /*<! payload capacity of this buffer */
+    uint8_t payload[];          /*<! Trailing buffer data */
+} data_buff_t;
+
+/*
+ * Receive queue of a socket. Buffers are appended to tail and consumed from head.
+ */
+typedef struct _rx_queue_t {
+    data_buff_t *head;          /*<! first buffer to be read */
+    data_buff_t *tail;          /*<! last received buffer */
+    uint16_t count;             /*<! number of buffers in queue */
+    uint32_t bytes;             /*<! number of unread bytes in queue */
+} rx_queue_t;
+
+/*
+ * \brief Initialize receive queue to empty state
+ * \param queue receive queue
+ */
+void ns_sal_rx_queue_init(rx_queue_t *queue);
+
+/*
+ * \brief Append buffer to the end of the receive queue
+ * \param queue receive queue
+ * \param data_buf buffer to append
+ */
+void ns_sal_rx_queue_enqueue(rx_queue_t *queue, data_buff_t *data_buf);
+
+/*
+ * \brief Remove first buffer from the receive queue
+ * \param queue receive queue
+ * \return removed buffer, NULL if queue is empty
+ */
+data_buff_t *ns_sal_rx_queue_dequeue(rx_queue_t *queue);
+
+/*
+ * \brief Mark data in first buffer of the receive queue read
+ * \param queue receive queue
+ * \param length number of bytes read, must be less than length of first buffer
+ */
+void ns_sal_rx_queue_consume(rx_queue_t *queue, uint16_t length);
+
+/*
+ * \brief Get unused space at the end of the last buffer in the receive queue
+ * \param queue receive queue
+ * \param length number of bytes needed
+ * \return pointer to the space, NULL if last buffer doesn't have enough space
+ */
+uint8_t *ns_sal_rx_queue_tail_space(rx_queue_t *queue, uint16_t length);
+
+/*
+ * \brief Add data written to the space returned by ns_sal_rx_queue_tail_space
+ * \param queue receive queue
+ * \param length number of bytes written
+ */
+void ns_sal_rx_queue_tail_extend(rx_queue_t *queue, uint16_t length);
+
+/*
+ * \brief Free all buffers in the receive queue
+ * \param queue receive queue
+ */
+void ns_sal_rx_queue_destroy(rx_queue_t *queue);
+
+/*
+ * Receive buffer pool statistics.
+ */
+typedef struct _rx_pool_stats_t {
+    uint32_t alloc_count;       /*<! buffers allocated from pool */
+    uint32_t free_count;        /*<! buffers returned to pool */
+    uint32_t fallback_count;    /*<! buffers allocated from heap as pool was exhausted */
+    uint32_t fail_count;        /*<! failed allocations */
+} rx_pool_stats_t;
+
+/*
+ * \brief Allocate receive buffer. Buffer is taken from the smallest free pool
+ * size class that fits the data. Heap is used only if the pool is exhausted.
+ * \param length payload length
+ * \return allocated buffer, NULL on failure
+ */
+data_buff_t *ns_sal_rx_buffer_alloc(uint16_t length);
+
+/*
+ * \brief Free receive buffer allocated with ns_sal_rx_buffer_alloc
+ * \param data_buf buffer to free
+ */
+void ns_sal_rx_buffer_free(data_buff_t *data_buf);
+
+/*
+ * \brief Read receive buffer pool statistics
+ * \param stats statistics are copied here
+ */
+void ns_sal_rx_pool_stats_get(rx_pool_stats_t *stats);
+
+/*
+ * Buffer for data waiting to be sent, when NanoStack is busy.
+ */
+typedef struct _tx_buff_t {
+    struct _tx_buff_t *next;    /*<! next buffer */
+    ns_address_t ns_address;    /*<! destination address, if use_address is set */
+    uint32_t queued_at;         /*<! time when buffer was queued, microseconds */
+    uint32_t seq;               /*<! bytes sent from socket when NanoStack accepted this buffer */
+    uint16_t length;            /*<! data length */
+    uint16_t size;              /*<! payload capacity */
+    uint8_t use_address;        /*<! 1 = send to ns_address, 0 = send to connected peer */
+    uint8_t owned;              /*<! 1 = application owned, returned to application when send completes */
+    uint8_t status;             /*<! send result of application owned buffer, socket_error_t */
+    uint8_t payload[];          /*<! Trailing buffer data */
+} tx_buff_t;
+
+/*
+ * Transmit queue of a socket. Buffers are appended to tail and sent from head.
+ */
+typedef struct _tx_queue_t {
+    tx_buff_t *head;            /*<! first buffer to be sent */
+    tx_buff_t *tail;            /*<! last queued buffer */
+    uint16_t count;             /*<! number of buffers in queue */
+    uint32_t bytes;             /*<! number of bytes in queue */
+} tx_queue_t;
+
+/*
+ * \brief Initialize transmit queue to empty state
+ * \param queue transmit queue
+ */
+void ns_sal_tx_queue_init(tx_queue_t *queue);
+
+/*
+ * \brief Append buffer to the end of the transmit queue
+ * \param queue transmit queue
+ * \param tx_buf buffer to append
+ */
+void ns_sal_tx_queue_enqueue(tx_queue_t *queue, tx_buff_t *tx_buf);
+
+/*
+ * \brief Remove first buffer from the transmit queue
+ * \param queue transmit queue
+ * \return removed buffer, NULL if queue is empty
+ */
+tx_buff_t *ns_sal_tx_queue_dequeue(tx_queue_t *queue);
+
+/*
+ * \brief Free all buffers in the transmit queue
+ * \param queue transmit queue
+ */
+void ns_sal_tx_queue_destroy(tx_queue_t *queue);
+
+/*
+ * \brief Allocate transmit buffer. Buffer is taken from the transmit buffer pool if it
+ * fits the data, heap is used only if the pool is exhausted.
+ * \param length payload length
+ * \return allocated buffer, NULL on failure
+ */
+tx_buff_t *ns_sal_tx_buffer_alloc(uint16_t length);
+
+/*
+ * \brief Free transmit buffer allocated with ns_sal_tx_buffer_alloc
+ * \param tx_buf buffer to free
+ */
+void ns_sal_tx_buffer_free(tx_buff_t *tx_buf);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _NS_SAL_BUFFER_H_ */
@@ -15,17 +15,6 @@
  */
 #ifndef _NS_SAL_CALLBACK_H_
 #define _NS_SAL_CALLBACK_H_
-/*
- * Buffer for the received datagram.
- * Every socket will contain received data in linked list.
- */
-typedef struct _data_buff_t {
-    struct _data_buff_t *next;  /*<! next buffer */
-    ns_address_t ns_address;    /*<! address where data is received */
-    uint16_t length;            /*<! data length in this buffer */
-    uint8_t payload[];          /*<! Trailing buffer data */
-} data_buff_t;
-
 
 /*
  * \brief address resolved callback
@@ -41,6 +30,41 @@ void ns_sal_callback_name_resolved(void *context, const char *address);
  */
 void ns_sal_callback_data_received(void *context, data_buff_t *data_buf);
 
+/*
+ * \brief Check if received data is left to NanoStack and read when application
+ * reads it. Done in NS_SAL_OPT_RX_DIRECT mode, and for stream data that does not
+ * fit to the receive queue limit, so that NanoStack flow control slows the sender
+ * instead of acknowledged data being dropped.
+ * \param context context that receives data
+ * \param length number of bytes received
+ * \return 1 if data is left to NanoStack, 0 if it is read to the receive queue
+ */
+uint8_t ns_sal_callback_rx_leave(void *context, uint16_t length);
+
+/*
+ * \brief Get space for received stream data at the end of the last receive buffer.
+ * Space is given only when NS_SAL_OPT_RX_COALESCE is set and the data fits to
+ * the receive queue limit.
+ * \param context context that receives data
+ * \param length number of bytes received
+ * \return pointer to the space, NULL if data must be stored to a new buffer
+ */
+uint8_t *ns_sal_callback_rx_append_space(void *context, uint16_t length);
+
+/*
+ * \brief Data appended callback, data was written to the space returned by
+ * ns_sal_callback_rx_append_space
+ * \param context context that receives data
+ * \param length number of bytes written
+ */
+void ns_sal_callback_rx_appended(void *context, uint16_t length);
+
+/*
+ * \brief Received data lost due to lack of memory callback
+ * \param context context that lost data
+ */
+void ns_sal_callback_rx_overrun(void *context);
+
 /*
  * \brief Data has been transmitted callback
  * \param context context that sends data
@@ -54,6 +78,12 @@ void ns_sal_callback_tx_done(void *context, uint16_t length);
  */
 void ns_sal_callback_tx_error(void *context);
 
+/*
+ * \brief Data transmission failed callback, NanoStack is ready for next transmission
+ * \param context sending data
+ */
+void ns_sal_callback_tx_failed(void *context);
+
 /*
  * \brief Socket connected callback
  * \param context connected
@@ -66,4 +96,54 @@ void ns_sal_callback_connect(void *context);
  */
 void ns_sal_callback_disconnect(void *context);
 
+/*
+ * \brief Send small writes held for coalescing, unless socket is corked.
+ * Called when previous send has completed.
+ * \param context socket that sends data
+ */
+void ns_sal_tx_coalesce_resume(void *context);
+
+/*
+ * \brief Check if paced socket may send now. Tokens are taken when NanoStack
+ * accepts the data.
+ * \param context socket that sends data
+ * \param length number of bytes to send
+ * \return 1 if data may be sent, 0 if it must wait
+ */
+uint8_t ns_sal_tx_pace_ready(void *context, uint16_t length);
+
+/*
+ * \brief SAL transmit timer expired. Sends coalesced data held longer than
+ * the coalescing delay and releases paced datagrams.
+ */
+void ns_sal_tx_timer_expired(void);
+
+/*
+ * \brief Send queued data that pacing and priority allow. Called from SAL
+ * transmit timer and when socket transmit settings change.
+ * \param context socket that sends data
+ */
+void ns_sal_callback_tx_ready(void *context);
+
+/*
+ * \brief Check if socket with given transmit priority must hold its data
+ * \param priority transmit priority of the socket
+ * \return 1 if socket with higher priority has data queued or in flight
+ */
+uint8_t ns_sal_tx_priority_blocked(uint8_t priority);
+
+/*
+ * \brief Set transmit priority of a socket
+ * \param context socket
+ * \param priority transmit priority 0 - NS_SAL_PRIORITY_MAX
+ */
+void ns_sal_tx_priority_set(void *context, uint8_t priority);
+
+/*
+ * \brief Socket stops sending, it is closed or destroyed. Data in flight no
+ * longer holds lower priority sockets.
+ * \param context socket, impl may be NULL if socket is destroyed
+ */
+void ns_sal_callback_tx_closed(void *context);
+
 #endif /* _NS_SAL_CALLBACK_H_ */
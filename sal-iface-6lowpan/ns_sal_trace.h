@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2015 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _NS_SAL_TRACE_H_
+#define _NS_SAL_TRACE_H_
+
+/*
+ * Trace level of the module, configurable via yotta config sal-iface-6lowpan.trace-level:
+ * 0 = no traces, 1 = errors, 2 = warnings, 3 = info, 4 = debug.
+ * Traces above the level are removed at compile time and their arguments are not
+ * evaluated, release builds should use level 1 or 0.
+ * Runtime trace level set with set_trace_config() still applies to compiled traces.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_TRACE_LEVEL
+#define NS_SAL_TRACE_LEVEL  YOTTA_CFG_SAL_IFACE_6LOWPAN_TRACE_LEVEL
+#else
+#define NS_SAL_TRACE_LEVEL  4
+#endif
+
+#if NS_SAL_TRACE_LEVEL > 0
+#define HAVE_DEBUG 1
+#endif
+#include "ns_trace.h"
+
+#if NS_SAL_TRACE_LEVEL < 4
+#undef tr_debug
+#define tr_debug(...)   ((void) 0)
+#endif
+#if NS_SAL_TRACE_LEVEL < 3
+#undef tr_info
+#define tr_info(...)    ((void) 0)
+#endif
+#if NS_SAL_TRACE_LEVEL < 2
+#undef tr_warn
+#define tr_warn(...)    ((void) 0)
+#endif
+#if NS_SAL_TRACE_LEVEL < 1
+#undef tr_error
+#define tr_error(...)   ((void) 0)
+#undef tr_err
+#define tr_err(...)     ((void) 0)
+#endif
+
+#endif /* _NS_SAL_TRACE_H_ */
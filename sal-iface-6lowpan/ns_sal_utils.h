@@ -16,6 +16,8 @@
 #ifndef _NS_SAL_UTILS_H_
 #define _NS_SAL_UTILS_H_
 
+struct socket_addr;
+
 /*
  * \brief Convert mbed socket address to NanoStack address
  * \param ns_addr nanoStack socket address astructure
@@ -35,4 +37,10 @@ void convert_mbed_addr_to_ns(ns_address_t *ns_addr, const struct socket_addr *s_
  */
 void convert_ns_addr_to_mbed(struct socket_addr *s_addr, const ns_address_t *ns_addr, uint16_t *port);
 
+/*
+ * \brief Read free running microsecond time, used for statistics
+ * \return current time in microseconds
+ */
+uint32_t ns_sal_time_us(void);
+
 #endif /* _NS_SAL_UTILS_H_ */
@@ -28,6 +28,28 @@
 extern "C" {
 #endif
 
+/*
+ * Size of socket handle table, configurable via yotta config sal-iface-6lowpan.sockets-max.
+ * Sockets with NanoStack socket ID above table size are refused.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_SOCKETS_MAX
+#define NS_WRAPPER_SOCKETS_MAX  YOTTA_CFG_SAL_IFACE_6LOWPAN_SOCKETS_MAX
+#else
+#define NS_WRAPPER_SOCKETS_MAX  16  //same as NanoStack SOCKET_MAX
+#endif
+#if NS_WRAPPER_SOCKETS_MAX > 127
+#error "NS_WRAPPER_SOCKETS_MAX must fit to NanoStack socket ID"
+#endif
+
+/*
+ * Socket handle, 16-bit generation above NanoStack socket ID in low byte.
+ * Generation is changed once when socket is freed, so handle of a freed socket
+ * does not match the next 65535 sockets that get the same socket ID.
+ */
+typedef uint32_t ns_wrapper_handle_t;
+#define NS_WRAPPER_HANDLE_ID(handle)    ((int8_t) ((handle) & 0xff))
+#define NS_WRAPPER_HANDLE_GEN(handle)   ((uint16_t) ((handle) >> 8))
+
 /* NanoStack socket types */
 #define NANOSTACK_SOCKET_UDP 17 // same as nanostack SOCKET_UDP
 #define NANOSTACK_SOCKET_TCP 6  // same as nanostack SOCKET_TCP
@@ -40,30 +62,112 @@ typedef void (*func_cb_t)(void);
  */
 typedef struct sock_data_ {
     int8_t socket_id;           /*!< allocated socket ID */
+    ns_wrapper_handle_t handle; /*!< socket handle, see ns_wrapper_socket_context_lookup() */
     int8_t security_session_id; /*!< Not used yet */
+    uint8_t rx_coalesce;        /*!< append received stream data to last buffer when possible */
+    uint8_t rcvbuf_policy;      /*!< ns_sal_rcvbuf_policy_t */
+    uint8_t rx_notify;          /*!< ns_sal_rx_notify_t */
+    uint16_t rx_borrowed;       /*!< bytes borrowed from first receive buffer, 0 if not borrowed */
+    uint8_t rx_direct;          /*!< leave received data to NanoStack until application reads it */
+    uint16_t rx_pending;        /*!< datagrams left to NanoStack in rx_direct mode, non-zero if stream data is left */
+    uint32_t rcvbuf_limit;      /*!< receive queue limit in bytes, 0 = no limit */
+    uint32_t rx_dropped;        /*!< datagrams dropped due to receive queue limit */
+    uint32_t rx_overrun;        /*!< received data lost due to lack of memory */
+    rx_queue_t rx_queue;        /*!< received data waiting to be read */
+    uint32_t sndq_limit;        /*!< transmit queue limit in bytes, 0 = queue disabled */
+    uint16_t tx_queue_max;      /*!< highest number of buffers in transmit queue */
+    uint32_t tx_queued;         /*!< number of sends queued since socket creation */
+    uint32_t tx_latency_last;   /*!< queueing time of last sent buffer, microseconds */
+    uint32_t tx_latency_max;    /*!< highest queueing time, microseconds */
+    tx_queue_t tx_queue;        /*!< data waiting for NanoStack to finish previous send */
+    uint8_t tx_in_flight;       /*!< data given to NanoStack, waiting for SOCKET_TX_DONE */
+    uint8_t tx_cork;            /*!< hold small writes until segment is full or socket is uncorked */
+    uint8_t tx_nodelay;         /*!< send small writes immediately */
+    uint16_t tx_coalesce_len;   /*!< bytes held in tx_coalesce_buf */
+    uint32_t tx_coalesce_at;    /*!< time when first held byte was written, microseconds */
+    uint8_t *tx_coalesce_buf;   /*!< small writes held for coalescing, allocated when needed */
+    uint8_t tx_timer;           /*!< 1 = socket paces or coalesces and uses SAL transmit timer */
+    uint32_t tx_seq_sent;       /*!< bytes accepted by NanoStack since socket creation */
+    uint32_t tx_seq_done;       /*!< bytes reported sent, or failed, by NanoStack since socket creation */
+    uint32_t sndbuf;            /*!< send buffer size for free space reporting, NS_SAL_OPT_SNDBUF */
+    uint32_t tx_pace_rate;      /*!< pacing rate in bytes per second, 0 = disabled */
+    uint32_t tx_pace_burst;     /*!< pacing bucket size in bytes */
+    int32_t tx_pace_tokens;     /*!< bytes that can be sent now, negative after datagram larger than bucket */
+    uint32_t tx_pace_at;        /*!< time of last token refill, microseconds */
+    uint32_t tx_flow_label;     /*!< IPv6 flow label */
+    uint8_t tx_tclass;          /*!< IPv6 traffic class */
+    uint8_t tx_priority;        /*!< transmit priority, NS_SAL_OPT_PRIORITY */
+    uint32_t event_mask;        /*!< events delivered to socket handler, NS_SAL_OPT_EVENT_MASK */
+    tx_queue_t tx_wait;         /*!< application owned buffers accepted by NanoStack, waiting for send completion */
+    tx_queue_t tx_complete;     /*!< application owned buffers waiting to be reclaimed by application */
 } sock_data_s;
 
+/*
+ * Deferred event dispatch statistics, see yotta config sal-iface-6lowpan.event-queue.
+ */
+typedef struct _ns_wrapper_event_stats_t {
+    uint32_t queued;            /*!< events queued in NanoStack socket callback */
+    uint32_t dispatched;        /*!< queued events delivered to sockets */
+    uint32_t stale;             /*!< queued events dropped as socket was freed before dispatch */
+    uint32_t overflow;          /*!< times queue was full and was dispatched in NanoStack callback */
+    uint32_t passes;            /*!< dispatch tasklet runs */
+    uint32_t latency_max;       /*!< longest time from queuing to dispatch, microseconds */
+    uint32_t handler_max;       /*!< longest time spent delivering one event, microseconds */
+    uint16_t depth_max;         /*!< highest number of queued events */
+} ns_wrapper_event_stats_t;
+
 /*
  * Nanostack wrapper functions
  */
 
 /*
- * \brief Open NanoStack socket
+ * \brief Open NanoStack socket. Socket data is kept in a static table indexed
+ * by socket ID, so no heap is used.
+ * \return socket data, NULL if NanoStack could not open a socket
  */
 sock_data_s *ns_wrapper_socket_open(int8_t socket_type, int8_t identifier, void *context);
 
 /*
- * \brief Bind NanoStack socket
+ * \brief Get context of NanoStack socket
+ * \param socket_id NanoStack socket ID, 0 to NS_WRAPPER_SOCKETS_MAX - 1
+ * \return context given in ns_wrapper_socket_open(), NULL if socket is not open
  */
-int8_t ns_wrapper_socket_bind(sock_data_s *sock_data_ptr, ns_address_t *address);
+void *ns_wrapper_socket_context_get(int8_t socket_id);
+
+/*
+ * \brief Get socket context by handle
+ * \param handle socket handle from sock_data_s
+ * \return socket context, NULL if socket has been freed
+ */
+void *ns_wrapper_socket_context_lookup(ns_wrapper_handle_t handle);
+
+/*
+ * \brief Read deferred event dispatch statistics
+ * \param stats statistics are copied here, all zero if event queue is disabled
+ */
+void ns_wrapper_event_stats_get(ns_wrapper_event_stats_t *stats);
+
+/*
+ * \brief Clear deferred event dispatch statistics
+ */
+void ns_wrapper_event_stats_reset(void);
+
+/*
+ * \brief Start or restart SAL transmit timer. ns_sal_tx_timer_expired() is called
+ * from an event tasklet when the timer expires.
+ * \param delay_ms timer delay in milliseconds
+ * \return 0 on success, -1 on failure
+ */
+int8_t ns_wrapper_tx_timer_start(uint32_t delay_ms);
 
 /*
- * \brief Release data allocated by NanoStack socket
+ * \brief Bind NanoStack socket
  */
-void ns_wrapper_release_socket_data(sock_data_s *sock_data_ptr);
+int8_t ns_wrapper_socket_bind(sock_data_s *sock_data_ptr, ns_address_t *address);
+
 
 /*
- * \brief Free resources allocated by NanoStack socket
+ * \brief Free NanoStack socket. Socket data must not be used after this.
  */
 int8_t ns_wrapper_socket_free(sock_data_s *sock_data_ptr);
 
@@ -77,6 +181,11 @@ int8_t ns_wrapper_socket_close(sock_data_s *sock_data_ptr);
  */
 int8_t ns_wrapper_socket_connect(sock_data_s *sock_data_ptr, ns_address_t *address);
 
+/*
+ * \brief Read received data from NanoStack socket
+ */
+int16_t ns_wrapper_socket_read(sock_data_s *sock_data_ptr, ns_address_t *address, uint8_t *buffer, uint16_t length);
+
 /*
  * \brief Send data to NanoStack socket
  */
@@ -87,6 +196,22 @@ int8_t ns_wrapper_socket_send(sock_data_s *sock_data_ptr, uint8_t *buffer, uint1
  */
 int8_t ns_wrapper_socket_send_to(sock_data_s *sock_data_ptr, ns_address_t *address, uint8_t *buffer, uint16_t length);
 
+/*
+ * \brief Send transmit buffer to NanoStack socket, to buffer address or to connected peer
+ */
+int8_t ns_wrapper_socket_send_buffer(sock_data_s *sock_data_ptr, tx_buff_t *tx_buf);
+
+/*
+ * \brief Set IPv6 traffic class of NanoStack socket
+ */
+int8_t ns_wrapper_socket_tclass_set(sock_data_s *sock_data_ptr, uint8_t tclass);
+
+/*
+ * \brief Set IPv6 flow label of NanoStack socket
+ * \return -1 if NanoStack does not support flow label
+ */
+int8_t ns_wrapper_socket_flow_label_set(sock_data_s *sock_data_ptr, uint32_t flow_label);
+
 #ifdef __cplusplus
 }
 #endif
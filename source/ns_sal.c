@@ -23,19 +23,58 @@
 #include "ns_address.h"
 #include "net_interface.h"
 #include "ip6string.h"  //stoip6
+#include "sal-iface-6lowpan/ns_sal_buffer.h"
 #include "sal-iface-6lowpan/ns_sal_callback.h"
 #include "sal-iface-6lowpan/ns_sal_utils.h"
 #include "sal-iface-6lowpan/ns_wrapper.h"
+#include "sal-iface-6lowpan/ns_sal.h"
 #include "common_functions.h"
 #include "nsdynmemLIB.h"
-// For tracing we need to define flag, have include and define group
-#define HAVE_DEBUG 1
-#include "ns_trace.h"
+// For tracing we need to include trace header and define group
+#include "sal-iface-6lowpan/ns_sal_trace.h"
 #define TRACE_GROUP  "ns_sal"
 
 #define MALLOC  ns_dyn_mem_alloc
 #define FREE    ns_dyn_mem_free
 
+/*
+ * Stream socket small write coalescing, configurable via yotta config
+ * sal-iface-6lowpan.tx-coalesce.size/delay. Held data is sent when segment
+ * size is reached, previous send completes or delay (ms) expires. Delay 0
+ * disables the timer.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_COALESCE_SIZE
+#define TX_COALESCE_SIZE    YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_COALESCE_SIZE
+#else
+#define TX_COALESCE_SIZE    64
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_COALESCE_DELAY
+#define TX_COALESCE_DELAY   YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_COALESCE_DELAY
+#else
+#define TX_COALESCE_DELAY   200
+#endif
+
+/*
+ * Default send buffer size (NS_SAL_OPT_SNDBUF), configurable via yotta config
+ * sal-iface-6lowpan.sndbuf.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_SNDBUF
+#define SNDBUF_DEFAULT      YOTTA_CFG_SAL_IFACE_6LOWPAN_SNDBUF
+#else
+#define SNDBUF_DEFAULT      2048
+#endif
+
+/*
+ * Interval (ms) of releasing paced datagrams, configurable via yotta config
+ * sal-iface-6lowpan.tx-pace.tick. Tick 0 disables pacing, NS_SAL_OPT_PACING
+ * then returns SOCKET_ERROR_UNIMPLEMENTED.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_PACE_TICK
+#define TX_PACE_TICK        YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_PACE_TICK
+#else
+#define TX_PACE_TICK        10
+#endif
+
 //#define FUNC_ENTRY_TRACE_ENABLED
 #ifdef FUNC_ENTRY_TRACE_ENABLED
 #define FUNC_ENTRY_TRACE    tr_debug
@@ -47,6 +86,10 @@
 // Forward declaration of this socket_api
 const struct socket_api nanostack_socket_api;
 
+static socket_error_t ns_sal_tx_coalesce_send(sock_data_s *sock_data_ptr);
+static socket_error_t ns_sal_tx_coalesce_flush(struct socket *socket);
+static void ns_sal_tx_timer_update(struct socket *socket, uint8_t needed);
+
 /*** PUBLIC METHODS ***/
 /*
  * \brief NanoStack initialization method. Called by application.
@@ -60,7 +103,8 @@ socket_error_t ns_sal_init_stack(void)
 void ns_sal_copy_datagrams(struct socket *socket, uint8_t *dest, size_t *len,
                            struct socket_addr *addr, uint16_t *port)
 {
-    data_buff_t *data_buf = (data_buff_t *) socket->rxBufChain;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    data_buff_t *data_buf = ns_sal_rx_queue_dequeue(&sock_data_ptr->rx_queue);
 
     if (addr && port) {
         convert_ns_addr_to_mbed(addr, &data_buf->ns_address, port);
@@ -71,44 +115,104 @@ void ns_sal_copy_datagrams(struct socket *socket, uint8_t *dest, size_t *len,
         data_buf->length = *len;
     }
 
-    memcpy(dest, data_buf->payload, data_buf->length);
+    memcpy(dest, &data_buf->payload[data_buf->offset], data_buf->length);
     *len = data_buf->length;
-    socket->rxBufChain = data_buf->next;
-    FREE(data_buf);
+    ns_sal_rx_buffer_free(data_buf);
+}
+
+socket_error_t ns_sal_read_direct(struct socket *socket, uint8_t *dest, size_t *len,
+                                  struct socket_addr *addr, uint16_t *port)
+{
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    ns_address_t ns_address;
+    uint16_t read_len = (*len > 0xffff) ? 0xffff : *len;
+
+    int16_t length = ns_wrapper_socket_read(sock_data_ptr, &ns_address, dest, read_len);
+    if (length <= 0) {
+        /* nothing left in NanoStack */
+        sock_data_ptr->rx_pending = 0;
+        return SOCKET_ERROR_WOULD_BLOCK;
+    }
+
+    if (SOCKET_DGRAM == socket->family) {
+        sock_data_ptr->rx_pending--;
+    } else if (length < read_len) {
+        /* stream data left to NanoStack was read completely */
+        sock_data_ptr->rx_pending = 0;
+    }
+
+    if (addr && port) {
+        convert_ns_addr_to_mbed(addr, &ns_address, port);
+    }
+    *len = length;
+    return SOCKET_ERROR_NONE;
+}
+
+/*
+ * Read one datagram, SAL receive queue is read first and then data left to NanoStack.
+ */
+socket_error_t ns_sal_read_datagram(struct socket *socket, uint8_t *dest, size_t *len,
+                                    struct socket_addr *addr, uint16_t *port)
+{
+    if (0 == ((sock_data_s *) socket->impl)->rx_queue.count) {
+        return ns_sal_read_direct(socket, dest, len, addr, port);
+    }
+    ns_sal_copy_datagrams(socket, dest, len, addr, port);
+    return SOCKET_ERROR_NONE;
 }
 
 void ns_sal_copy_stream(struct socket *socket, uint8_t *dest, size_t *len)
 {
     uint16_t copied_total = 0;
-    data_buff_t *data_buf = (data_buff_t *) socket->rxBufChain;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    data_buff_t *data_buf = sock_data_ptr->rx_queue.head;
 
     for (; *len != 0 && NULL != data_buf;) {
         if ((data_buf->length + copied_total) > *len) {
             /* Partial copy, more data than space avail */
             uint16_t partial_amount = *len - copied_total;
             if (0 != partial_amount) {
-                memcpy(&dest[copied_total], &data_buf->payload, partial_amount);
+                memcpy(&dest[copied_total], &data_buf->payload[data_buf->offset], partial_amount);
                 copied_total += partial_amount;
-                /* move memory to start of payload and adjust length */
-                memmove(&data_buf->payload[0],
-                        &data_buf->payload[partial_amount],
-                        data_buf->length - partial_amount);
-                data_buf->length -= partial_amount;
+                /* skip consumed data and adjust length */
+                ns_sal_rx_queue_consume(&sock_data_ptr->rx_queue, partial_amount);
             }
             break;
         } else {
             /* Full copy, copy whole buffer to dest and move next one to first */
-            memcpy(&dest[copied_total], data_buf->payload, data_buf->length);
+            memcpy(&dest[copied_total], &data_buf->payload[data_buf->offset], data_buf->length);
             copied_total += data_buf->length;
-            socket->rxBufChain = data_buf->next;
-            FREE(data_buf);
-            data_buf = (data_buff_t *)socket->rxBufChain;
+            ns_sal_rx_buffer_free(ns_sal_rx_queue_dequeue(&sock_data_ptr->rx_queue));
+            data_buf = sock_data_ptr->rx_queue.head;
         }
     } /* for space avail and data available */
 
     *len = copied_total;
 }
 
+void ns_sal_peek(struct socket *socket, struct ns_sal_rx_peek *peek)
+{
+    size_t copied_total = 0;
+    data_buff_t *data_buf = ((sock_data_s *) socket->impl)->rx_queue.head;
+
+    convert_ns_addr_to_mbed(&peek->addr, &data_buf->ns_address, &peek->port);
+
+    for (; NULL != data_buf && copied_total < peek->len; data_buf = data_buf->next) {
+        size_t amount = data_buf->length;
+        if (amount > peek->len - copied_total) {
+            amount = peek->len - copied_total;
+        }
+        memcpy((uint8_t *) peek->buf + copied_total, &data_buf->payload[data_buf->offset], amount);
+        copied_total += amount;
+        if (SOCKET_DGRAM == socket->family) {
+            /* only one datagram at a time */
+            break;
+        }
+    }
+
+    peek->len = copied_total;
+}
+
 socket_error_t ns_sal_recv_validate(struct socket *socket, void *buf, size_t *len)
 {
     if (socket == NULL || len == NULL || buf == NULL || socket->impl == NULL) {
@@ -119,7 +223,12 @@ socket_error_t ns_sal_recv_validate(struct socket *socket, void *buf, size_t *le
         return SOCKET_ERROR_SIZE;
     }
 
-    if (NULL == socket->rxBufChain) {
+    if (0 != ((sock_data_s *) socket->impl)->rx_borrowed) {
+        return SOCKET_ERROR_BUSY;
+    }
+
+    if (0 == ((sock_data_s *) socket->impl)->rx_queue.count &&
+            0 == ((sock_data_s *) socket->impl)->rx_pending) {
         return SOCKET_ERROR_WOULD_BLOCK;
     }
 
@@ -167,11 +276,39 @@ static socket_error_t ns_sal_socket_create(struct socket *sock,
     }
 
     if (NULL == sock_data_ptr) {
+        // out of NanoStack sockets
         return SOCKET_ERROR_BAD_ALLOC;
-    } else if (-1 == sock_data_ptr->socket_id) {
-        ns_wrapper_release_socket_data(sock_data_ptr);
-        return SOCKET_ERROR_UNKNOWN;
     }
+    sock_data_ptr->rx_coalesce = 0;
+    sock_data_ptr->rx_borrowed = 0;
+    sock_data_ptr->rx_direct = 0;
+    sock_data_ptr->rx_pending = 0;
+    sock_data_ptr->rx_notify = NS_SAL_RX_NOTIFY_ALL;
+    sock_data_ptr->rcvbuf_policy = NS_SAL_RCVBUF_DROP_NEWEST;
+    sock_data_ptr->rcvbuf_limit = 0;
+    sock_data_ptr->rx_dropped = 0;
+    sock_data_ptr->rx_overrun = 0;
+    sock_data_ptr->sndq_limit = 0;
+    sock_data_ptr->tx_queue_max = 0;
+    sock_data_ptr->tx_queued = 0;
+    sock_data_ptr->tx_latency_last = 0;
+    sock_data_ptr->tx_latency_max = 0;
+    sock_data_ptr->tx_in_flight = 0;
+    sock_data_ptr->tx_cork = 0;
+    sock_data_ptr->tx_nodelay = 1;
+    sock_data_ptr->tx_coalesce_len = 0;
+    sock_data_ptr->tx_coalesce_at = 0;
+    sock_data_ptr->tx_coalesce_buf = NULL;
+    sock_data_ptr->tx_timer = 0;
+    sock_data_ptr->sndbuf = SNDBUF_DEFAULT;
+    sock_data_ptr->tx_pace_rate = 0;
+    sock_data_ptr->tx_pace_burst = 0;
+    sock_data_ptr->tx_pace_tokens = 0;
+    sock_data_ptr->tx_pace_at = 0;
+    sock_data_ptr->tx_flow_label = 0;
+    sock_data_ptr->tx_tclass = 0;
+    sock_data_ptr->tx_priority = 0;
+    sock_data_ptr->event_mask = NS_SAL_EVENT_MASK_ALL;
     sock->impl = sock_data_ptr;
     sock->family = pf;
     sock->handler = (void *) handler;
@@ -188,21 +325,23 @@ static socket_error_t ns_sal_socket_destroy(struct socket *sock)
         return SOCKET_ERROR_NULL_PTR;
     }
 
-    data_buff_t *data_buf = (data_buff_t *)sock->rxBufChain;
-    while (NULL != data_buf) {
-        data_buff_t *tmp_buf = data_buf;
-        data_buf = data_buf->next;
-        FREE(tmp_buf);
-    }
-
     sock->rxBufChain = NULL;
 
     if (NULL != sock->impl) {
+        ns_sal_rx_queue_destroy(&((sock_data_s *) sock->impl)->rx_queue);
+        ns_sal_tx_queue_destroy(&((sock_data_s *) sock->impl)->tx_queue);
+        ns_sal_tx_queue_destroy(&((sock_data_s *) sock->impl)->tx_wait);
+        ns_sal_tx_queue_destroy(&((sock_data_s *) sock->impl)->tx_complete);
+        FREE(((sock_data_s *) sock->impl)->tx_coalesce_buf);
+        ns_sal_tx_priority_set(sock, 0);
+        ns_sal_tx_timer_update(sock, 0);
         int8_t status = ns_wrapper_socket_free(sock->impl);
         sock->impl = NULL;
         if (0 != status) {
             err = SOCKET_ERROR_UNKNOWN;
         }
+        // lower priority sockets may continue
+        ns_sal_callback_tx_closed(sock);
     }
 
     return err;
@@ -217,7 +356,15 @@ static socket_error_t ns_sal_socket_close(struct socket *sock)
         return SOCKET_ERROR_NULL_PTR;
     }
 
+    // send held small writes before closing, corked or not
+    error = ns_sal_tx_coalesce_send((sock_data_s *) sock->impl);
+    if (SOCKET_ERROR_NONE != error) {
+        return error;
+    }
     return_value = ns_wrapper_socket_close(sock->impl);
+    if (0 == return_value) {
+        ns_sal_callback_tx_closed(sock);
+    }
 
     switch (return_value) {
         case 0:
@@ -275,6 +422,117 @@ socket_error_t ns_sal_socket_connect(struct socket *sock,
     return error_code;
 }
 
+/* sockets using the transmit timer, see ns_sal_tx_timer_update() */
+static uint8_t tx_timer_pace_sockets = 0;
+static uint8_t tx_timer_coalesce_sockets = 0;
+/* interval of running transmit timer, ms, 0 if timer is not running */
+static uint32_t tx_timer_interval = 0;
+
+/*
+ * Check if socket needs the transmit timer, i.e. it paces datagrams or coalesces small writes.
+ */
+static uint8_t ns_sal_tx_timer_needed(const struct socket *socket)
+{
+    const sock_data_s *sock_data_ptr = (const sock_data_s *) socket->impl;
+
+#if TX_COALESCE_DELAY
+    if (SOCKET_STREAM == socket->family &&
+            (sock_data_ptr->tx_cork || !sock_data_ptr->tx_nodelay)) {
+        return 1;
+    }
+#endif
+#if TX_PACE_TICK
+    if (SOCKET_DGRAM == socket->family && sock_data_ptr->tx_pace_rate > 0) {
+        return 1;
+    }
+#endif
+    (void) sock_data_ptr;
+    return 0;
+}
+
+/*
+ * Start transmit timer if a socket needs it. Timer already running with
+ * the same or shorter interval is left running.
+ */
+static void ns_sal_tx_timer_start(void)
+{
+    uint32_t interval = 0;
+
+#if TX_COALESCE_DELAY
+    if (tx_timer_coalesce_sockets > 0) {
+        interval = TX_COALESCE_DELAY;
+    }
+#endif
+#if TX_PACE_TICK
+    if (tx_timer_pace_sockets > 0 && (0 == interval || TX_PACE_TICK < interval)) {
+        interval = TX_PACE_TICK;
+    }
+#endif
+    if (0 == interval || (0 != tx_timer_interval && tx_timer_interval <= interval)) {
+        return;
+    }
+    if (0 != ns_wrapper_tx_timer_start(interval)) {
+        tr_error("transmit timer start failed");
+        return;
+    }
+    tx_timer_interval = interval;
+}
+
+/*
+ * Count socket as transmit timer user, and start the timer, when socket starts
+ * pacing or coalescing. The options are set after the socket periodic task has
+ * been queried on socket open, so the periodic task cannot be used for this.
+ * \param needed 1 if socket needs the timer, 0 when it no longer does or is destroyed
+ */
+static void ns_sal_tx_timer_update(struct socket *socket, uint8_t needed)
+{
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    uint8_t *users = (SOCKET_STREAM == socket->family) ? &tx_timer_coalesce_sockets : &tx_timer_pace_sockets;
+
+    if (needed == sock_data_ptr->tx_timer) {
+        return;
+    }
+    sock_data_ptr->tx_timer = needed;
+    if (needed) {
+        (*users)++;
+        ns_sal_tx_timer_start();
+    } else {
+        (*users)--;
+    }
+}
+
+void ns_sal_tx_timer_expired(void)
+{
+    uint32_t now = ns_sal_time_us();
+    int8_t socket_id;
+
+    tx_timer_interval = 0;
+    for (socket_id = 0; socket_id < NS_WRAPPER_SOCKETS_MAX; socket_id++) {
+        struct socket *socket = ns_wrapper_socket_context_get(socket_id);
+        sock_data_s *sock_data_ptr;
+        if (NULL == socket || NULL == socket->impl || !((sock_data_s *) socket->impl)->tx_timer) {
+            continue;
+        }
+        sock_data_ptr = (sock_data_s *) socket->impl;
+#if TX_COALESCE_DELAY
+        /* send coalesced data that has been held longer than the delay */
+        if (sock_data_ptr->tx_coalesce_len > 0 &&
+                now - sock_data_ptr->tx_coalesce_at >= TX_COALESCE_DELAY * 1000UL) {
+            ns_sal_tx_coalesce_send(sock_data_ptr);
+        }
+#endif
+#if TX_PACE_TICK
+        /* release paced datagrams */
+        if (sock_data_ptr->tx_pace_rate > 0 && sock_data_ptr->tx_queue.count > 0) {
+            ns_sal_callback_tx_ready(socket);
+        }
+#endif
+    }
+    (void) now;
+    // keep running while sockets need it
+    ns_sal_tx_timer_start();
+}
+
 void periodic_task(void)
 {
     /* this function will be called periodically when used, empty at the moment */
@@ -383,18 +641,69 @@ socket_error_t ns_sal_socket_reject(struct socket *socket)
     return SOCKET_ERROR_UNIMPLEMENTED;
 }
 
-/* socket_api function, see socket_api.h for details */
-socket_error_t ns_sal_socket_send(struct socket *socket, const void *buf,
-                                  const size_t len)
+/*
+ * Append buffer to transmit queue and update queue statistics.
+ */
+static void ns_sal_tx_queue_put(sock_data_s *sock_data_ptr, tx_buff_t *tx_buf)
 {
-    socket_error_t err = SOCKET_ERROR_UNKNOWN;
+    tx_buf->queued_at = ns_sal_time_us();
+    ns_sal_tx_queue_enqueue(&sock_data_ptr->tx_queue, tx_buf);
 
-    if (NULL == socket || NULL == socket->impl) {
-        return SOCKET_ERROR_NULL_PTR;
+    sock_data_ptr->tx_queued++;
+    if (sock_data_ptr->tx_queue.count > sock_data_ptr->tx_queue_max) {
+        sock_data_ptr->tx_queue_max = sock_data_ptr->tx_queue.count;
     }
+}
+
+/*
+ * Check if transmit queue has space for len bytes.
+ */
+static uint8_t ns_sal_tx_queue_space(const sock_data_s *sock_data_ptr, size_t len)
+{
+    uint32_t limit = sock_data_ptr->sndq_limit;
+
+    if (0 == limit) {
+        /* data held by pacing or priority is queued up to send buffer size */
+        limit = sock_data_ptr->sndbuf;
+    }
+    return sock_data_ptr->tx_queue.bytes + len <= limit;
+}
+
+/*
+ * Queue data to be sent when NanoStack has finished previous send.
+ * \param ns_address destination address, NULL for connected peer
+ */
+static socket_error_t ns_sal_tx_queue_add(sock_data_s *sock_data_ptr, const ns_address_t *ns_address,
+                                          const void *buf, size_t len)
+{
+    tx_buff_t *tx_buf;
+
+    if (!ns_sal_tx_queue_space(sock_data_ptr, len)) {
+        return SOCKET_ERROR_BUSY;
+    }
+
+    tx_buf = ns_sal_tx_buffer_alloc(len);
+    if (NULL == tx_buf) {
+        return SOCKET_ERROR_BAD_ALLOC;
+    }
+    if (NULL != ns_address) {
+        tx_buf->ns_address = *ns_address;
+        tx_buf->use_address = 1;
+    } else {
+        tx_buf->use_address = 0;
+    }
+    memcpy(tx_buf->payload, buf, len);
+    ns_sal_tx_queue_put(sock_data_ptr, tx_buf);
+    return SOCKET_ERROR_NONE;
+}
+
+/*
+ * Map NanoStack send return value to socket error.
+ */
+static socket_error_t ns_sal_send_error(int8_t status)
+{
+    socket_error_t err;
 
-    int8_t status = ns_wrapper_socket_send(socket->impl, (uint8_t *) buf,
-            len);
     switch (status) {
         case 0:
             err = SOCKET_ERROR_NONE;
@@ -409,148 +718,1187 @@ socket_error_t ns_sal_socket_send(struct socket *socket, const void *buf,
         case -3:
             err = SOCKET_ERROR_NO_CONNECTION;
             break;
+        case -4:
+            err = SOCKET_ERROR_BUSY;
+            break;
         default:
-            /* -4, 5 */
+            /* -5 */
             err = SOCKET_ERROR_UNKNOWN;
             break;
     }
     return err;
 }
 
-/* socket_api function, see socket_api.h for details */
-socket_error_t ns_sal_socket_send_to(struct socket *socket, const void *buf,
-                                     const size_t len, const struct socket_addr *addr, const uint16_t port)
+/*
+ * Refill pacing bucket and check if length bytes may be sent now.
+ */
+static uint8_t ns_sal_pace_ready(sock_data_s *sock_data_ptr, uint16_t length)
 {
-    socket_error_t error_status = SOCKET_ERROR_NONE;
-    int8_t send_to_status;
+    uint32_t now;
+    uint32_t tokens;
 
-    FUNC_ENTRY_TRACE("ns_sal_socket_send_to()");
-    if (NULL == socket || NULL == socket->impl || NULL == buf || NULL == addr) {
-        return SOCKET_ERROR_NULL_PTR;
+    if (0 == sock_data_ptr->tx_pace_rate) {
+        return 1;
     }
 
-    if (len <= 0) {
-        return SOCKET_ERROR_SIZE;
+    now = ns_sal_time_us();
+    tokens = (uint64_t)(now - sock_data_ptr->tx_pace_at) * sock_data_ptr->tx_pace_rate / 1000000;
+    if (tokens > 0) {
+        /* keep fraction of token for next refill */
+        sock_data_ptr->tx_pace_at += (uint64_t) tokens * 1000000 / sock_data_ptr->tx_pace_rate;
+        if (sock_data_ptr->tx_pace_tokens + (int64_t) tokens >= (int64_t) sock_data_ptr->tx_pace_burst) {
+            sock_data_ptr->tx_pace_tokens = sock_data_ptr->tx_pace_burst;
+            sock_data_ptr->tx_pace_at = now;
+        } else {
+            sock_data_ptr->tx_pace_tokens += tokens;
+        }
     }
 
-    switch (socket->family) {
-        case SOCKET_DGRAM: {
-            ns_address_t ns_address;
-            convert_mbed_addr_to_ns(&ns_address, addr, port);
-            send_to_status = ns_wrapper_socket_send_to(socket->impl,
-                             &ns_address, (uint8_t *) buf, len);
-            /*
-             * \return 0 on success.
-             * \return -1 invalid socket id.
-             * \return -2 Socket memory allocation fail.
-             * \return -3 TCP state not established.
-             * \return -4 Socket tx process busy.
-             * \return -5 TLS authentication not ready.
-             * \return -6 Packet too short.
-             * */
-
-            if (0 != send_to_status) {
-                tr_error("ns_sal_socket_send_to: error=%d", send_to_status);
-                error_status = SOCKET_ERROR_UNKNOWN;
-            }
-            break;
-        }
-        case SOCKET_STREAM:
-            tr_error("send_to() not supported with SOCKET_STREAM!");
-            error_status = SOCKET_ERROR_BAD_FAMILY;
-            break;
+    if (sock_data_ptr->tx_pace_tokens >= (int32_t) length) {
+        return 1;
     }
+    /* datagram larger than bucket is sent when bucket is full */
+    return sock_data_ptr->tx_pace_tokens >= (int32_t) sock_data_ptr->tx_pace_burst;
+}
 
-    return error_status;
+uint8_t ns_sal_tx_pace_ready(void *context, uint16_t length)
+{
+    return ns_sal_pace_ready((sock_data_s *)((struct socket *) context)->impl, length);
 }
 
-/* socket_api function, see socket_api.h for details */
-socket_error_t ns_sal_socket_recv(struct socket *socket, void *buf,
-                                  size_t *len)
+/*
+ * Check if data must be queued before passing it to NanoStack: to keep order,
+ * or due to pacing or transmit priority.
+ */
+static uint8_t ns_sal_tx_hold(sock_data_s *sock_data_ptr, uint16_t length)
 {
-    FUNC_ENTRY_TRACE("ns_sal_socket_recv() len=%d", *len);
+    return sock_data_ptr->tx_queue.count > 0 || !ns_sal_pace_ready(sock_data_ptr, length) ||
+           ns_sal_tx_priority_blocked(sock_data_ptr->tx_priority);
+}
 
-    socket_error_t err = ns_sal_recv_validate(socket, buf, len);
+/*
+ * Check if data is queued instead of returning SOCKET_ERROR_BUSY when NanoStack is busy.
+ */
+static uint8_t ns_sal_tx_queue_enabled(const sock_data_s *sock_data_ptr)
+{
+    return sock_data_ptr->sndq_limit > 0 || sock_data_ptr->tx_pace_rate > 0;
+}
 
-    if (err != SOCKET_ERROR_NONE) {
-        if (err == SOCKET_ERROR_WOULD_BLOCK) {
-            // check if connection is closed by remote end
-            if (!(socket->status & SOCKET_STATUS_CONNECTED))
-            {
-                *len = 0;
-                return SOCKET_ERROR_NO_CONNECTION;
-            }
-        }
-        return err;
+/*
+ * Send data to connected peer, or queue it if NanoStack is busy.
+ */
+static socket_error_t ns_sal_send_data(sock_data_s *sock_data_ptr, const void *buf, size_t len)
+{
+    if (NULL != buf && len > 0 && ns_sal_tx_hold(sock_data_ptr, len)) {
+        /* keep order, NanoStack gets this data after queued data */
+        return ns_sal_tx_queue_add(sock_data_ptr, NULL, buf, len);
     }
 
-    if (SOCKET_DGRAM == socket->family) {
-        ns_sal_copy_datagrams(socket, buf, len, NULL, NULL);
-    } else {
-        ns_sal_copy_stream(socket, buf, len);
+    int8_t status = ns_wrapper_socket_send(sock_data_ptr, (uint8_t *) buf,
+            len);
+    if (-4 == status && ns_sal_tx_queue_enabled(sock_data_ptr)) {
+        return ns_sal_tx_queue_add(sock_data_ptr, NULL, buf, len);
     }
+    return ns_sal_send_error(status);
+}
 
-    //tr_debug("received %d bytes", *len);
+static socket_error_t ns_sal_tx_coalesce_send(sock_data_s *sock_data_ptr)
+{
+    socket_error_t err;
 
-    return SOCKET_ERROR_NONE;
+    if (0 == sock_data_ptr->tx_coalesce_len) {
+        return SOCKET_ERROR_NONE;
+    }
+    err = ns_sal_send_data(sock_data_ptr, sock_data_ptr->tx_coalesce_buf, sock_data_ptr->tx_coalesce_len);
+    if (SOCKET_ERROR_NONE == err) {
+        sock_data_ptr->tx_coalesce_len = 0;
+    }
+    return err;
 }
 
-/* socket_api function, see socket_api.h for details */
-socket_error_t ns_sal_socket_recv_from(struct socket *socket, void *buf,
-                                       size_t *len, struct socket_addr *addr, uint16_t *port)
+static socket_error_t ns_sal_tx_coalesce_flush(struct socket *socket)
 {
-    /* socket and socket->impl will be validated in ns_sal_recv_validate */
-    if (NULL == addr || NULL == port) {
-        return SOCKET_ERROR_NULL_PTR;
-    }
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
 
-    if (SOCKET_STREAM == socket->family) {
-        tr_error("recv_from() not supported with SOCKET_STREAM!");
-        return SOCKET_ERROR_BAD_FAMILY;
+    if (NULL == sock_data_ptr || sock_data_ptr->tx_cork) {
+        return SOCKET_ERROR_NONE;
     }
+    return ns_sal_tx_coalesce_send(sock_data_ptr);
+}
 
-    socket_error_t err = ns_sal_recv_validate(socket, buf, len);
-    if (err != SOCKET_ERROR_NONE) {
-        return err;
-    }
+void ns_sal_tx_coalesce_resume(void *context)
+{
+    ns_sal_tx_coalesce_flush((struct socket *) context);
+}
 
-    ns_sal_copy_datagrams(socket, buf, len, addr, port);
+/*
+ * Copy stream write shorter than a segment to coalescing buffer. Held data is
+ * sent first if the write does not fit after it.
+ * \param hold 0 to send the data now, 1 to hold it until segment is full
+ * \return SOCKET_ERROR_BAD_ALLOC if coalescing buffer cannot be allocated
+ */
+static socket_error_t ns_sal_tx_coalesce_gather(sock_data_s *sock_data_ptr, const struct ns_sal_iovec *iov,
+                                                size_t iovcnt, size_t len, uint8_t hold)
+{
+    socket_error_t err;
+    size_t i;
+
+    if (sock_data_ptr->tx_coalesce_len + len > TX_COALESCE_SIZE) {
+        // make room, held data goes first
+        err = ns_sal_tx_coalesce_send(sock_data_ptr);
+        if (SOCKET_ERROR_NONE != err) {
+            return err;
+        }
+    }
+    if (NULL == sock_data_ptr->tx_coalesce_buf) {
+        sock_data_ptr->tx_coalesce_buf = MALLOC(TX_COALESCE_SIZE);
+        if (NULL == sock_data_ptr->tx_coalesce_buf) {
+            return SOCKET_ERROR_BAD_ALLOC;
+        }
+    }
+    if (0 == sock_data_ptr->tx_coalesce_len) {
+        sock_data_ptr->tx_coalesce_at = ns_sal_time_us();
+    }
+    for (i = 0; i < iovcnt; i++) {
+        memcpy(&sock_data_ptr->tx_coalesce_buf[sock_data_ptr->tx_coalesce_len], iov[i].base, iov[i].len);
+        sock_data_ptr->tx_coalesce_len += iov[i].len;
+    }
 
+    if (!hold || TX_COALESCE_SIZE == sock_data_ptr->tx_coalesce_len) {
+        // data stays held if NanoStack does not accept it now
+        ns_sal_tx_coalesce_send(sock_data_ptr);
+    }
     return SOCKET_ERROR_NONE;
 }
 
-/* socket_api function, see socket_api.h for details */
-socket_error_t ns_sal_socket_set_option(struct socket *socket, const socket_proto_level_t level,
-        const socket_option_type_t type, const void *option, const size_t optionSize)
+/*
+ * Hold small stream writes until segment is full, previous send completes
+ * or socket is uncorked.
+ */
+static socket_error_t ns_sal_tx_coalesce(sock_data_s *sock_data_ptr, const void *buf, size_t len)
 {
-    tr_error("ns_sal_socket_set_option() unimplemented!");
-    (void) socket;
-    (void) level;
-    (void) type;
-    (void) option;
-    (void) optionSize;
+    socket_error_t err;
+    struct ns_sal_iovec iov;
+    uint8_t hold = sock_data_ptr->tx_cork || sock_data_ptr->tx_in_flight ||
+                   sock_data_ptr->tx_queue.count > 0;
 
-    return SOCKET_ERROR_UNIMPLEMENTED;
-}
+    if (!hold && 0 == sock_data_ptr->tx_coalesce_len) {
+        return ns_sal_send_data(sock_data_ptr, buf, len);
+    }
 
-/* socket_api function, see socket_api.h for details */
-socket_error_t ns_sal_socket_get_option(struct socket *socket, const socket_proto_level_t level,
-        const socket_option_type_t type, void *option, const size_t optionSize)
-{
-    tr_error("ns_sal_socket_get_option() unimplemented!");
-    (void) socket;
-    (void) level;
-    (void) type;
-    (void) option;
-    (void) optionSize;
+    if (len >= TX_COALESCE_SIZE) {
+        // held data goes first
+        err = ns_sal_tx_coalesce_send(sock_data_ptr);
+        if (SOCKET_ERROR_NONE != err) {
+            return err;
+        }
+        return ns_sal_send_data(sock_data_ptr, buf, len);
+    }
 
-    return SOCKET_ERROR_UNIMPLEMENTED;
+    iov.base = buf;
+    iov.len = len;
+    err = ns_sal_tx_coalesce_gather(sock_data_ptr, &iov, 1, len, hold);
+    if (SOCKET_ERROR_BAD_ALLOC == err) {
+        return ns_sal_send_data(sock_data_ptr, buf, len);
+    }
+    return err;
 }
 
-/* socket_api function, see socket_api.h for details */
-uint8_t ns_sal_socket_is_connected(const struct socket *socket)
+/*
+ * Check if application owned buffers are waiting in transmit queue.
+ */
+static uint8_t ns_sal_tx_queue_owned(const sock_data_s *sock_data_ptr)
 {
-    return (socket->status & SOCKET_STATUS_CONNECTED);
+    const tx_buff_t *tx_buf;
+
+    for (tx_buf = sock_data_ptr->tx_queue.head; NULL != tx_buf; tx_buf = tx_buf->next) {
+        if (tx_buf->owned) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* socket_api function, see socket_api.h for details */
+socket_error_t ns_sal_socket_send(struct socket *socket, const void *buf,
+                                  const size_t len)
+{
+    sock_data_s *sock_data_ptr;
+
+    if (NULL == socket || NULL == socket->impl) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+    sock_data_ptr = (sock_data_s *) socket->impl;
+
+    if (SOCKET_STREAM == socket->family && NULL != buf && len > 0 &&
+            (sock_data_ptr->tx_cork || !sock_data_ptr->tx_nodelay || sock_data_ptr->tx_coalesce_len > 0)) {
+        return ns_sal_tx_coalesce(sock_data_ptr, buf, len);
+    }
+    return ns_sal_send_data(sock_data_ptr, buf, len);
+}
+
+/*
+ * Send datagram to NanoStack address, or queue it if NanoStack is busy.
+ */
+static socket_error_t ns_sal_send_datagram(sock_data_s *sock_data_ptr, ns_address_t *ns_address,
+                                           const void *buf, size_t len)
+{
+    int8_t send_to_status;
+
+    if (ns_sal_tx_hold(sock_data_ptr, len)) {
+        /* keep order, NanoStack gets this datagram after queued datagrams */
+        return ns_sal_tx_queue_add(sock_data_ptr, ns_address, buf, len);
+    }
+    send_to_status = ns_wrapper_socket_send_to(sock_data_ptr,
+                     ns_address, (uint8_t *) buf, len);
+    /*
+     * \return 0 on success.
+     * \return -1 invalid socket id.
+     * \return -2 Socket memory allocation fail.
+     * \return -3 TCP state not established.
+     * \return -4 Socket tx process busy.
+     * \return -5 TLS authentication not ready.
+     * \return -6 Packet too short.
+     * */
+
+    if (-4 == send_to_status) {
+        if (ns_sal_tx_queue_enabled(sock_data_ptr)) {
+            return ns_sal_tx_queue_add(sock_data_ptr, ns_address, buf, len);
+        }
+        return SOCKET_ERROR_BUSY;
+    } else if (0 != send_to_status) {
+        tr_error("ns_sal_socket_send_to: error=%d", send_to_status);
+        return SOCKET_ERROR_UNKNOWN;
+    }
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api function, see socket_api.h for details */
+socket_error_t ns_sal_socket_send_to(struct socket *socket, const void *buf,
+                                     const size_t len, const struct socket_addr *addr, const uint16_t port)
+{
+    socket_error_t error_status = SOCKET_ERROR_NONE;
+
+    FUNC_ENTRY_TRACE("ns_sal_socket_send_to()");
+    if (NULL == socket || NULL == socket->impl || NULL == buf || NULL == addr) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+
+    if (len <= 0) {
+        return SOCKET_ERROR_SIZE;
+    }
+
+    switch (socket->family) {
+        case SOCKET_DGRAM: {
+            ns_address_t ns_address;
+            convert_mbed_addr_to_ns(&ns_address, addr, port);
+            error_status = ns_sal_send_datagram(socket->impl, &ns_address, buf, len);
+            break;
+        }
+        case SOCKET_STREAM:
+            tr_error("send_to() not supported with SOCKET_STREAM!");
+            error_status = SOCKET_ERROR_BAD_FAMILY;
+            break;
+    }
+
+    return error_status;
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_send_to_batch(struct socket *socket, const struct ns_sal_datagram *dgrams,
+                                           socket_error_t *status, size_t count)
+{
+    socket_error_t err = SOCKET_ERROR_NONE;
+    ns_address_t ns_address;
+    const struct ns_sal_datagram *prev = NULL;
+    uint8_t busy = 0;
+    size_t i;
+
+    FUNC_ENTRY_TRACE("ns_sal_socket_send_to_batch()");
+    if (NULL == socket || NULL == socket->impl || NULL == dgrams || NULL == status) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+    if (SOCKET_DGRAM != socket->family) {
+        tr_error("send_to_batch() not supported with SOCKET_STREAM!");
+        return SOCKET_ERROR_BAD_FAMILY;
+    }
+
+    for (i = 0; i < count; i++) {
+        const struct ns_sal_datagram *dgram = &dgrams[i];
+        if (NULL == dgram->buf) {
+            status[i] = SOCKET_ERROR_NULL_PTR;
+        } else if (0 == dgram->len || dgram->len > 0xffff) {
+            status[i] = SOCKET_ERROR_SIZE;
+        } else if (busy) {
+            /* NanoStack is busy and there is no queue space, keep order */
+            status[i] = SOCKET_ERROR_BUSY;
+        } else {
+            /* address is converted only when destination changes */
+            if (NULL == prev || prev->port != dgram->port ||
+                    memcmp(prev->addr.ipv6be, dgram->addr.ipv6be, sizeof(dgram->addr.ipv6be))) {
+                convert_mbed_addr_to_ns(&ns_address, &dgram->addr, dgram->port);
+                prev = dgram;
+            }
+            status[i] = ns_sal_send_datagram(socket->impl, &ns_address, dgram->buf, dgram->len);
+            busy = (SOCKET_ERROR_BUSY == status[i]);
+        }
+        if (SOCKET_ERROR_NONE == err) {
+            err = status[i];
+        }
+    }
+
+    return err;
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+ns_sal_tx_handle_t ns_sal_tx_alloc(size_t size, uint8_t **data)
+{
+    tx_buff_t *tx_buf;
+
+    if (NULL == data || 0 == size || size > 0xffff) {
+        return NULL;
+    }
+    tx_buf = ns_sal_tx_buffer_alloc(size);
+    if (NULL != tx_buf) {
+        tx_buf->owned = 1;
+        *data = tx_buf->payload;
+    }
+    return tx_buf;
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+void ns_sal_tx_free(ns_sal_tx_handle_t handle)
+{
+    if (NULL != handle) {
+        ns_sal_tx_buffer_free(handle);
+    }
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_send_buffer(struct socket *socket, ns_sal_tx_handle_t handle, size_t len,
+                                         const struct socket_addr *addr, const uint16_t port)
+{
+    sock_data_s *sock_data_ptr;
+    int8_t status;
+
+    FUNC_ENTRY_TRACE("ns_sal_socket_send_buffer()");
+    if (NULL == socket || NULL == socket->impl || NULL == handle) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+    if (0 == len || len > handle->size) {
+        return SOCKET_ERROR_SIZE;
+    }
+    sock_data_ptr = (sock_data_s *) socket->impl;
+
+    handle->use_address = 0;
+    if (SOCKET_STREAM == socket->family) {
+        if (NULL != addr) {
+            return SOCKET_ERROR_BAD_FAMILY;
+        }
+        if (sock_data_ptr->tx_cork && len < TX_COALESCE_SIZE && !ns_sal_tx_queue_owned(sock_data_ptr)) {
+            /* corked data is copied and held, buffer is returned after data sent before it */
+            struct ns_sal_iovec iov = {handle->payload, len};
+            socket_error_t err = ns_sal_tx_coalesce_gather(sock_data_ptr, &iov, 1, len, 1);
+            if (SOCKET_ERROR_NONE != err) {
+                return err;
+            }
+            handle->seq = sock_data_ptr->tx_seq_sent;
+            handle->status = SOCKET_ERROR_NONE;
+            ns_sal_tx_queue_enqueue(NULL != sock_data_ptr->tx_wait.head ? &sock_data_ptr->tx_wait :
+                                    &sock_data_ptr->tx_complete, handle);
+            return SOCKET_ERROR_NONE;
+        }
+        // held small writes go first
+        socket_error_t err = ns_sal_tx_coalesce_send(sock_data_ptr);
+        if (SOCKET_ERROR_NONE != err) {
+            return err;
+        }
+    } else if (NULL != addr) {
+        convert_mbed_addr_to_ns(&handle->ns_address, addr, port);
+        handle->use_address = 1;
+    }
+    handle->length = len;
+
+    if (!ns_sal_tx_hold(sock_data_ptr, len)) {
+        status = ns_wrapper_socket_send_buffer(sock_data_ptr, handle);
+        if (0 == status) {
+            handle->seq = sock_data_ptr->tx_seq_sent;
+            ns_sal_tx_queue_enqueue(&sock_data_ptr->tx_wait, handle);
+            return SOCKET_ERROR_NONE;
+        }
+        if (-4 != status || !ns_sal_tx_queue_enabled(sock_data_ptr)) {
+            // buffer stays owned by application
+            return ns_sal_send_error(status);
+        }
+    }
+
+    /* keep order, buffer is queued without copying */
+    if (!ns_sal_tx_queue_space(sock_data_ptr, len)) {
+        // buffer stays owned by application
+        return SOCKET_ERROR_BUSY;
+    }
+    ns_sal_tx_queue_put(sock_data_ptr, handle);
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_tx_reclaim(struct socket *socket, ns_sal_tx_handle_t *handle, socket_error_t *status)
+{
+    sock_data_s *sock_data_ptr;
+    tx_buff_t *tx_buf;
+
+    if (NULL == socket || NULL == socket->impl || NULL == handle) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+    sock_data_ptr = (sock_data_s *) socket->impl;
+
+    tx_buf = ns_sal_tx_queue_dequeue(&sock_data_ptr->tx_complete);
+    if (NULL == tx_buf) {
+        return SOCKET_ERROR_WOULD_BLOCK;
+    }
+    *handle = tx_buf;
+    if (NULL != status) {
+        *status = (socket_error_t) tx_buf->status;
+    }
+    return SOCKET_ERROR_NONE;
+}
+
+/*
+ * Validate I/O vector and count its total length.
+ */
+static socket_error_t ns_sal_iov_length(const struct ns_sal_iovec *iov, size_t iovcnt, size_t *len)
+{
+    size_t i;
+    size_t total = 0;
+
+    if (NULL == iov) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+    if (0 == iovcnt) {
+        return SOCKET_ERROR_SIZE;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        if (NULL == iov[i].base && iov[i].len > 0) {
+            return SOCKET_ERROR_NULL_PTR;
+        }
+        total += iov[i].len;
+    }
+    if (0 == total || total > 0xffff) {
+        /* NanoStack send length is 16 bits */
+        return SOCKET_ERROR_SIZE;
+    }
+
+    *len = total;
+    return SOCKET_ERROR_NONE;
+}
+
+/*
+ * Gather I/O vector to a transmit buffer, so that the buffer can be queued
+ * without copying the data again.
+ */
+static tx_buff_t *ns_sal_gather(const struct ns_sal_iovec *iov, size_t iovcnt, size_t len)
+{
+    tx_buff_t *tx_buf = ns_sal_tx_buffer_alloc(len);
+    size_t i;
+
+    if (NULL != tx_buf) {
+        len = 0;
+        for (i = 0; i < iovcnt; i++) {
+            memcpy(&tx_buf->payload[len], iov[i].base, iov[i].len);
+            len += iov[i].len;
+        }
+    }
+    return tx_buf;
+}
+
+/*
+ * Send gathered transmit buffer, or queue it if NanoStack is busy.
+ * Buffer is freed when it is not queued, NanoStack has copied the data.
+ */
+static socket_error_t ns_sal_send_gathered(sock_data_s *sock_data_ptr, tx_buff_t *tx_buf)
+{
+    int8_t status;
+
+    if (!ns_sal_tx_hold(sock_data_ptr, tx_buf->length)) {
+        status = ns_wrapper_socket_send_buffer(sock_data_ptr, tx_buf);
+        if (-4 != status || !ns_sal_tx_queue_enabled(sock_data_ptr)) {
+            ns_sal_tx_buffer_free(tx_buf);
+            return ns_sal_send_error(status);
+        }
+    }
+
+    /* keep order, buffer is queued without copying */
+    if (!ns_sal_tx_queue_space(sock_data_ptr, tx_buf->length)) {
+        ns_sal_tx_buffer_free(tx_buf);
+        return SOCKET_ERROR_BUSY;
+    }
+    ns_sal_tx_queue_put(sock_data_ptr, tx_buf);
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_sendv(struct socket *socket, const struct ns_sal_iovec *iov, size_t iovcnt)
+{
+    sock_data_s *sock_data_ptr;
+    socket_error_t err;
+    tx_buff_t *tx_buf;
+    size_t len;
+
+    FUNC_ENTRY_TRACE("ns_sal_socket_sendv()");
+    if (NULL == socket || NULL == socket->impl) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+    sock_data_ptr = (sock_data_s *) socket->impl;
+
+    err = ns_sal_iov_length(iov, iovcnt, &len);
+    if (err != SOCKET_ERROR_NONE) {
+        return err;
+    }
+    if (1 == iovcnt) {
+        return ns_sal_socket_send(socket, iov[0].base, len);
+    }
+
+    if (SOCKET_STREAM == socket->family) {
+        if (sock_data_ptr->tx_cork && len < TX_COALESCE_SIZE) {
+            // corked data is held until segment is full or socket is uncorked
+            return ns_sal_tx_coalesce_gather(sock_data_ptr, iov, iovcnt, len, 1);
+        }
+        // held small writes go first
+        err = ns_sal_tx_coalesce_send(sock_data_ptr);
+        if (SOCKET_ERROR_NONE != err) {
+            return err;
+        }
+    }
+    tx_buf = ns_sal_gather(iov, iovcnt, len);
+    if (NULL == tx_buf) {
+        return SOCKET_ERROR_BAD_ALLOC;
+    }
+    tx_buf->use_address = 0;
+    return ns_sal_send_gathered(sock_data_ptr, tx_buf);
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_sendv_to(struct socket *socket, const struct ns_sal_iovec *iov, size_t iovcnt,
+                                      const struct socket_addr *addr, const uint16_t port)
+{
+    socket_error_t err;
+    tx_buff_t *tx_buf;
+    size_t len;
+
+    FUNC_ENTRY_TRACE("ns_sal_socket_sendv_to()");
+    if (NULL == socket || NULL == socket->impl || NULL == addr) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+    if (SOCKET_DGRAM != socket->family) {
+        tr_error("sendv_to() not supported with SOCKET_STREAM!");
+        return SOCKET_ERROR_BAD_FAMILY;
+    }
+
+    err = ns_sal_iov_length(iov, iovcnt, &len);
+    if (err != SOCKET_ERROR_NONE) {
+        return err;
+    }
+    if (1 == iovcnt) {
+        return ns_sal_socket_send_to(socket, iov[0].base, len, addr, port);
+    }
+
+    tx_buf = ns_sal_gather(iov, iovcnt, len);
+    if (NULL == tx_buf) {
+        return SOCKET_ERROR_BAD_ALLOC;
+    }
+    convert_mbed_addr_to_ns(&tx_buf->ns_address, addr, port);
+    tx_buf->use_address = 1;
+    return ns_sal_send_gathered((sock_data_s *) socket->impl, tx_buf);
+}
+
+/* socket_api function, see socket_api.h for details */
+socket_error_t ns_sal_socket_recv(struct socket *socket, void *buf,
+                                  size_t *len)
+{
+    FUNC_ENTRY_TRACE("ns_sal_socket_recv() len=%d", *len);
+
+    socket_error_t err = ns_sal_recv_validate(socket, buf, len);
+
+    if (err != SOCKET_ERROR_NONE) {
+        if (err == SOCKET_ERROR_WOULD_BLOCK) {
+            // check if connection is closed by remote end
+            if (!(socket->status & SOCKET_STATUS_CONNECTED))
+            {
+                *len = 0;
+                return SOCKET_ERROR_NO_CONNECTION;
+            }
+        }
+        return err;
+    }
+
+    if (SOCKET_DGRAM == socket->family) {
+        err = ns_sal_read_datagram(socket, buf, len, NULL, NULL);
+    } else {
+        size_t space = *len;
+        ns_sal_copy_stream(socket, buf, len);
+        if (*len < space && 0 != ((sock_data_s *) socket->impl)->rx_pending) {
+            /* fill rest of the buffer with data left to NanoStack */
+            size_t direct_len = space - *len;
+            if (SOCKET_ERROR_NONE == ns_sal_read_direct(socket, (uint8_t *) buf + *len,
+                    &direct_len, NULL, NULL)) {
+                *len += direct_len;
+            } else if (0 == *len) {
+                err = SOCKET_ERROR_WOULD_BLOCK;
+            }
+        }
+    }
+
+    //tr_debug("received %d bytes", *len);
+
+    return err;
+}
+
+/* socket_api function, see socket_api.h for details */
+socket_error_t ns_sal_socket_recv_from(struct socket *socket, void *buf,
+                                       size_t *len, struct socket_addr *addr, uint16_t *port)
+{
+    /* socket and socket->impl will be validated in ns_sal_recv_validate */
+    if (NULL == addr || NULL == port) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+
+    if (SOCKET_STREAM == socket->family) {
+        tr_error("recv_from() not supported with SOCKET_STREAM!");
+        return SOCKET_ERROR_BAD_FAMILY;
+    }
+
+    socket_error_t err = ns_sal_recv_validate(socket, buf, len);
+    if (err != SOCKET_ERROR_NONE) {
+        return err;
+    }
+
+    return ns_sal_read_datagram(socket, buf, len, addr, port);
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_recv_borrow(struct socket *socket, const uint8_t **data, size_t *len,
+        struct socket_addr *addr, uint16_t *port)
+{
+    if (NULL == socket || NULL == socket->impl || NULL == data || NULL == len) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    data_buff_t *data_buf = sock_data_ptr->rx_queue.head;
+
+    if (0 != sock_data_ptr->rx_borrowed) {
+        return SOCKET_ERROR_BUSY;
+    }
+
+    if (NULL == data_buf) {
+        if (SOCKET_STREAM == socket->family && !(socket->status & SOCKET_STATUS_CONNECTED)) {
+            *len = 0;
+            return SOCKET_ERROR_NO_CONNECTION;
+        }
+        return SOCKET_ERROR_WOULD_BLOCK;
+    }
+
+    if (addr && port) {
+        convert_ns_addr_to_mbed(addr, &data_buf->ns_address, port);
+    }
+
+    *data = &data_buf->payload[data_buf->offset];
+    *len = data_buf->length;
+    sock_data_ptr->rx_borrowed = data_buf->length;
+
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_recv_release(struct socket *socket)
+{
+    if (NULL == socket || NULL == socket->impl) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    rx_queue_t *queue = &sock_data_ptr->rx_queue;
+
+    if (0 == sock_data_ptr->rx_borrowed) {
+        return SOCKET_ERROR_BAD_ARGUMENT;
+    }
+
+    if (SOCKET_STREAM == socket->family && queue->head->length > sock_data_ptr->rx_borrowed) {
+        /* stream data was appended after borrowing, keep it */
+        ns_sal_rx_queue_consume(queue, sock_data_ptr->rx_borrowed);
+    } else {
+        ns_sal_rx_buffer_free(ns_sal_rx_queue_dequeue(queue));
+    }
+    sock_data_ptr->rx_borrowed = 0;
+
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api extension function, see ns_sal.h for details */
+socket_error_t ns_sal_socket_recv_from_batch(struct socket *socket, struct ns_sal_datagram *dgrams,
+        size_t *count)
+{
+    size_t i;
+
+    if (NULL == socket || NULL == dgrams || NULL == count) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+
+    if (SOCKET_DGRAM != socket->family) {
+        tr_error("recv_from_batch() supported only with SOCKET_DGRAM!");
+        return SOCKET_ERROR_BAD_FAMILY;
+    }
+
+    for (i = 0; i < *count; i++) {
+        if (NULL == dgrams[i].buf) {
+            return SOCKET_ERROR_NULL_PTR;
+        }
+        if (0 == dgrams[i].len) {
+            return SOCKET_ERROR_SIZE;
+        }
+    }
+
+    socket_error_t err = ns_sal_recv_validate(socket, dgrams, count);
+    if (err != SOCKET_ERROR_NONE) {
+        return err;
+    }
+
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    for (i = 0; i < *count; i++) {
+        if (0 == sock_data_ptr->rx_queue.count && 0 == sock_data_ptr->rx_pending) {
+            break;
+        }
+        if (SOCKET_ERROR_NONE != ns_sal_read_datagram(socket, dgrams[i].buf, &dgrams[i].len,
+                &dgrams[i].addr, &dgrams[i].port)) {
+            break;
+        }
+    }
+    *count = i;
+
+    if (0 == i) {
+        return SOCKET_ERROR_WOULD_BLOCK;
+    }
+
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api function, see socket_api.h for details */
+socket_error_t ns_sal_socket_set_option(struct socket *socket, const socket_proto_level_t level,
+        const socket_option_type_t type, const void *option, const size_t optionSize)
+{
+    (void) level;
+
+    if (NULL == socket || NULL == socket->impl) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    switch ((uint32_t) type) {
+        case NS_SAL_OPT_RCVBUF:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            sock_data_ptr->rcvbuf_limit = *(const uint32_t *) option;
+            break;
+        case NS_SAL_OPT_RCVBUF_POLICY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (*(const uint8_t *) option > NS_SAL_RCVBUF_REJECT) {
+                return SOCKET_ERROR_BAD_ARGUMENT;
+            }
+            sock_data_ptr->rcvbuf_policy = *(const uint8_t *) option;
+            break;
+        case NS_SAL_OPT_RX_COALESCE:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (SOCKET_STREAM != socket->family) {
+                return SOCKET_ERROR_BAD_FAMILY;
+            }
+            sock_data_ptr->rx_coalesce = (0 != *(const uint8_t *) option);
+            break;
+        case NS_SAL_OPT_RX_DIRECT:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            sock_data_ptr->rx_direct = (0 != *(const uint8_t *) option);
+            break;
+        case NS_SAL_OPT_CORK:
+        case NS_SAL_OPT_NODELAY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (SOCKET_STREAM != socket->family) {
+                return SOCKET_ERROR_BAD_FAMILY;
+            }
+            if (NS_SAL_OPT_CORK == type) {
+                sock_data_ptr->tx_cork = (0 != *(const uint8_t *) option);
+            } else {
+                sock_data_ptr->tx_nodelay = (0 != *(const uint8_t *) option);
+            }
+            ns_sal_tx_timer_update(socket, ns_sal_tx_timer_needed(socket));
+            if (!sock_data_ptr->tx_cork &&
+                    (sock_data_ptr->tx_nodelay || !sock_data_ptr->tx_in_flight)) {
+                // uncorked, send held data now
+                return ns_sal_tx_coalesce_flush(socket);
+            }
+            break;
+        case NS_SAL_OPT_SNDQUEUE:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            /* already queued data is sent even if the new limit is smaller */
+            sock_data_ptr->sndq_limit = *(const uint32_t *) option;
+            break;
+        case NS_SAL_OPT_SNDBUF:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            sock_data_ptr->sndbuf = *(const uint32_t *) option;
+            break;
+        case NS_SAL_OPT_EVENT_MASK:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            sock_data_ptr->event_mask = *(const uint32_t *) option;
+            break;
+        case NS_SAL_OPT_PACING: {
+            const struct ns_sal_pacing *pacing = (const struct ns_sal_pacing *) option;
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(struct ns_sal_pacing)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (SOCKET_DGRAM != socket->family) {
+                return SOCKET_ERROR_BAD_FAMILY;
+            }
+#if !TX_PACE_TICK
+            // nothing would release held datagrams
+            if (pacing->rate > 0) {
+                return SOCKET_ERROR_UNIMPLEMENTED;
+            }
+#endif
+            if (pacing->rate > 0 && (0 == pacing->burst || pacing->burst > INT32_MAX)) {
+                return SOCKET_ERROR_BAD_ARGUMENT;
+            }
+            sock_data_ptr->tx_pace_rate = pacing->rate;
+            sock_data_ptr->tx_pace_burst = pacing->burst;
+            /* start with full bucket */
+            sock_data_ptr->tx_pace_tokens = pacing->burst;
+            sock_data_ptr->tx_pace_at = ns_sal_time_us();
+            ns_sal_tx_timer_update(socket, ns_sal_tx_timer_needed(socket));
+            // send datagrams new settings allow
+            ns_sal_callback_tx_ready(socket);
+            break;
+        }
+        case NS_SAL_OPT_TCLASS:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (0 != ns_wrapper_socket_tclass_set(sock_data_ptr, *(const uint8_t *) option)) {
+                return SOCKET_ERROR_UNKNOWN;
+            }
+            sock_data_ptr->tx_tclass = *(const uint8_t *) option;
+            break;
+        case NS_SAL_OPT_FLOW_LABEL:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (*(const uint32_t *) option > 0xfffff) {
+                return SOCKET_ERROR_BAD_ARGUMENT;
+            }
+            if (0 != ns_wrapper_socket_flow_label_set(sock_data_ptr, *(const uint32_t *) option)) {
+                return SOCKET_ERROR_UNIMPLEMENTED;
+            }
+            sock_data_ptr->tx_flow_label = *(const uint32_t *) option;
+            break;
+        case NS_SAL_OPT_PRIORITY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (*(const uint8_t *) option > NS_SAL_PRIORITY_MAX) {
+                return SOCKET_ERROR_BAD_ARGUMENT;
+            }
+            ns_sal_tx_priority_set(socket, *(const uint8_t *) option);
+            // held data of this or other sockets may be sent now
+            ns_sal_callback_tx_ready(socket);
+            break;
+        case NS_SAL_OPT_RX_NOTIFY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            if (*(const uint8_t *) option > NS_SAL_RX_NOTIFY_EDGE) {
+                return SOCKET_ERROR_BAD_ARGUMENT;
+            }
+            sock_data_ptr->rx_notify = *(const uint8_t *) option;
+            break;
+        default:
+            tr_error("ns_sal_socket_set_option() option %d unimplemented!", type);
+            return SOCKET_ERROR_UNIMPLEMENTED;
+    }
+
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api function, see socket_api.h for details */
+socket_error_t ns_sal_socket_get_option(struct socket *socket, const socket_proto_level_t level,
+        const socket_option_type_t type, void *option, const size_t optionSize)
+{
+    (void) level;
+
+    if (NULL == socket || NULL == socket->impl) {
+        return SOCKET_ERROR_NULL_PTR;
+    }
+
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    switch ((uint32_t) type) {
+        case NS_SAL_OPT_RCVBUF:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint32_t *) option = sock_data_ptr->rcvbuf_limit;
+            break;
+        case NS_SAL_OPT_RCVBUF_POLICY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint8_t *) option = sock_data_ptr->rcvbuf_policy;
+            break;
+        case NS_SAL_OPT_RX_COALESCE:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint8_t *) option = sock_data_ptr->rx_coalesce;
+            break;
+        case NS_SAL_OPT_RX_DIRECT:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint8_t *) option = sock_data_ptr->rx_direct;
+            break;
+        case NS_SAL_OPT_RX_NOTIFY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint8_t *) option = sock_data_ptr->rx_notify;
+            break;
+        case NS_SAL_OPT_RX_QUEUED: {
+            struct ns_sal_rx_queued *queued = (struct ns_sal_rx_queued *) option;
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(struct ns_sal_rx_queued)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            queued->bytes = sock_data_ptr->rx_queue.bytes;
+            queued->count = sock_data_ptr->rx_queue.count;
+            queued->next_len = sock_data_ptr->rx_queue.head ? sock_data_ptr->rx_queue.head->length : 0;
+            break;
+        }
+        case NS_SAL_OPT_RX_PEEK: {
+            struct ns_sal_rx_peek *peek = (struct ns_sal_rx_peek *) option;
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(struct ns_sal_rx_peek)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            socket_error_t err = ns_sal_recv_validate(socket, peek->buf, &peek->len);
+            if (err != SOCKET_ERROR_NONE) {
+                return err;
+            }
+            if (0 == sock_data_ptr->rx_queue.count) {
+                /* only data left to NanoStack */
+                return SOCKET_ERROR_WOULD_BLOCK;
+            }
+            ns_sal_peek(socket, peek);
+            break;
+        }
+        case NS_SAL_OPT_RX_DROPPED:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint32_t *) option = sock_data_ptr->rx_dropped;
+            break;
+        case NS_SAL_OPT_RX_OVERRUN:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint32_t *) option = sock_data_ptr->rx_overrun;
+            break;
+        case NS_SAL_OPT_SNDQUEUE:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint32_t *) option = sock_data_ptr->sndq_limit;
+            break;
+        case NS_SAL_OPT_SNDBUF:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint32_t *) option = sock_data_ptr->sndbuf;
+            break;
+        case NS_SAL_OPT_EVENT_MASK:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint32_t *) option = sock_data_ptr->event_mask;
+            break;
+        case NS_SAL_OPT_PACING: {
+            struct ns_sal_pacing *pacing = (struct ns_sal_pacing *) option;
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(struct ns_sal_pacing)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            pacing->rate = sock_data_ptr->tx_pace_rate;
+            pacing->burst = sock_data_ptr->tx_pace_burst;
+            break;
+        }
+        case NS_SAL_OPT_TCLASS:
+        case NS_SAL_OPT_PRIORITY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint8_t *) option = (NS_SAL_OPT_TCLASS == type) ? sock_data_ptr->tx_tclass : sock_data_ptr->tx_priority;
+            break;
+        case NS_SAL_OPT_FLOW_LABEL:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint32_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint32_t *) option = sock_data_ptr->tx_flow_label;
+            break;
+        case NS_SAL_OPT_SNDSPACE: {
+            struct ns_sal_tx_space *space = (struct ns_sal_tx_space *) option;
+            uint32_t used;
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(struct ns_sal_tx_space)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            space->in_flight = sock_data_ptr->tx_seq_sent - sock_data_ptr->tx_seq_done;
+            space->queued = sock_data_ptr->tx_queue.bytes + sock_data_ptr->tx_coalesce_len;
+            used = space->in_flight + space->queued;
+            space->free = (used < sock_data_ptr->sndbuf) ? sock_data_ptr->sndbuf - used : 0;
+            break;
+        }
+        case NS_SAL_OPT_CORK:
+        case NS_SAL_OPT_NODELAY:
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(uint8_t)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            *(uint8_t *) option = (NS_SAL_OPT_CORK == type) ? sock_data_ptr->tx_cork : sock_data_ptr->tx_nodelay;
+            break;
+        case NS_SAL_OPT_TX_QUEUE_STATS: {
+            struct ns_sal_tx_queue_stats *stats = (struct ns_sal_tx_queue_stats *) option;
+            if (NULL == option) {
+                return SOCKET_ERROR_NULL_PTR;
+            }
+            if (optionSize != sizeof(struct ns_sal_tx_queue_stats)) {
+                return SOCKET_ERROR_SIZE;
+            }
+            stats->bytes = sock_data_ptr->tx_queue.bytes;
+            stats->count = sock_data_ptr->tx_queue.count;
+            stats->max_count = sock_data_ptr->tx_queue_max;
+            stats->queued = sock_data_ptr->tx_queued;
+            stats->latency_last_us = sock_data_ptr->tx_latency_last;
+            stats->latency_max_us = sock_data_ptr->tx_latency_max;
+            break;
+        }
+        default:
+            tr_error("ns_sal_socket_get_option() option %d unimplemented!", type);
+            return SOCKET_ERROR_UNIMPLEMENTED;
+    }
+
+    return SOCKET_ERROR_NONE;
+}
+
+/* socket_api function, see socket_api.h for details */
+uint8_t ns_sal_socket_is_connected(const struct socket *socket)
+{
+    return (socket->status & SOCKET_STATUS_CONNECTED);
 }
 
 /* socket_api function, see socket_api.h for details */
@@ -636,3 +1984,19 @@ const struct socket_api nanostack_socket_api = {
     .get_local_port = ns_sal_socket_get_local_port,
     .get_remote_port = ns_sal_socket_get_remote_port
 };
+
+/*
+ * NanoStack specific socket API extensions.
+ */
+const struct ns_sal_socket_api_ext nanostack_socket_api_ext = {
+    .recv_borrow = ns_sal_socket_recv_borrow,
+    .recv_release = ns_sal_socket_recv_release,
+    .recv_from_batch = ns_sal_socket_recv_from_batch,
+    .sendv = ns_sal_socket_sendv,
+    .sendv_to = ns_sal_socket_sendv_to,
+    .send_to_batch = ns_sal_socket_send_to_batch,
+    .tx_alloc = ns_sal_tx_alloc,
+    .tx_free = ns_sal_tx_free,
+    .send_buffer = ns_sal_socket_send_buffer,
+    .tx_reclaim = ns_sal_socket_tx_reclaim
+};
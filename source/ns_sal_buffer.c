@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2015 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * NanoStack Socket Abstraction Layer (SAL) receive and transmit buffer handling.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ns_address.h"
+#include "nsdynmemLIB.h"
+#include "sal-iface-6lowpan/ns_sal_buffer.h"
+
+#define MALLOC  ns_dyn_mem_alloc
+#define FREE    ns_dyn_mem_free
+
+/*
+ * Receive buffer pool size classes, configurable via yotta config
+ * sal-iface-6lowpan.rx-pool.<class>.count/size. Set count to 0 to disable a class.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_SMALL_COUNT
+#define RX_POOL_SMALL_COUNT YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_SMALL_COUNT
+#else
+#define RX_POOL_SMALL_COUNT 8
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_SMALL_SIZE
+#define RX_POOL_SMALL_SIZE  YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_SMALL_SIZE
+#else
+#define RX_POOL_SMALL_SIZE  128
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_MEDIUM_COUNT
+#define RX_POOL_MEDIUM_COUNT YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_MEDIUM_COUNT
+#else
+#define RX_POOL_MEDIUM_COUNT 8
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_MEDIUM_SIZE
+#define RX_POOL_MEDIUM_SIZE YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_MEDIUM_SIZE
+#else
+#define RX_POOL_MEDIUM_SIZE 512
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_LARGE_COUNT
+#define RX_POOL_LARGE_COUNT YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_LARGE_COUNT
+#else
+#define RX_POOL_LARGE_COUNT 4
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_LARGE_SIZE
+#define RX_POOL_LARGE_SIZE  YOTTA_CFG_SAL_IFACE_6LOWPAN_RX_POOL_LARGE_SIZE
+#else
+#define RX_POOL_LARGE_SIZE  1280
+#endif
+
+/* size of one pool buffer in 32-bit words, keeps buffers aligned */
+#define RX_POOL_WORDS(size) ((sizeof(data_buff_t) + (size) + 3) / 4)
+/* storage size in words, at least one word so that disabled classes compile */
+#define RX_POOL_STORAGE(count, size) ((count) ? (count) * RX_POOL_WORDS(size) : 1)
+
+// pool size class
+typedef struct _rx_pool_class_t {
+    uint32_t *storage;          /*<! buffer storage */
+    uint16_t payload_size;      /*<! max payload length of buffer */
+    uint16_t count;             /*<! number of buffers in class */
+    data_buff_t *free_list;     /*<! free buffers */
+} rx_pool_class_t;
+
+static uint32_t rx_pool_small[RX_POOL_STORAGE(RX_POOL_SMALL_COUNT, RX_POOL_SMALL_SIZE)];
+static uint32_t rx_pool_medium[RX_POOL_STORAGE(RX_POOL_MEDIUM_COUNT, RX_POOL_MEDIUM_SIZE)];
+static uint32_t rx_pool_large[RX_POOL_STORAGE(RX_POOL_LARGE_COUNT, RX_POOL_LARGE_SIZE)];
+
+// size classes in increasing payload size order
+static rx_pool_class_t rx_pool_tbl[] = {
+    {rx_pool_small, RX_POOL_SMALL_SIZE, RX_POOL_SMALL_COUNT, NULL},
+    {rx_pool_medium, RX_POOL_MEDIUM_SIZE, RX_POOL_MEDIUM_COUNT, NULL},
+    {rx_pool_large, RX_POOL_LARGE_SIZE, RX_POOL_LARGE_COUNT, NULL},
+};
+#define RX_POOL_CLASS_COUNT (sizeof(rx_pool_tbl) / sizeof(rx_pool_tbl[0]))
+
+/*
+ * Transmit buffer pool, configurable via yotta config sal-iface-6lowpan.tx-pool.count/size.
+ * Set count to 0 to allocate all transmit buffers from heap.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_POOL_COUNT
+#define TX_POOL_COUNT YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_POOL_COUNT
+#else
+#define TX_POOL_COUNT 4
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_POOL_SIZE
+#define TX_POOL_SIZE  YOTTA_CFG_SAL_IFACE_6LOWPAN_TX_POOL_SIZE
+#else
+#define TX_POOL_SIZE  512
+#endif
+
+/* size of one transmit pool buffer in 32-bit words */
+#define TX_POOL_WORDS ((sizeof(tx_buff_t) + TX_POOL_SIZE + 3) / 4)
+
+static uint32_t tx_pool_storage[TX_POOL_COUNT ? TX_POOL_COUNT * TX_POOL_WORDS : 1];
+static tx_buff_t *tx_pool_free_list = NULL;
+static uint8_t tx_pool_initialized = 0;
+
+static rx_pool_stats_t rx_pool_stats;
+static uint8_t rx_pool_initialized = 0;
+
+static void ns_sal_rx_pool_init(void)
+{
+    uint8_t i;
+    uint16_t j;
+
+    for (i = 0; i < RX_POOL_CLASS_COUNT; i++) {
+        rx_pool_class_t *pool_class = &rx_pool_tbl[i];
+        pool_class->free_list = NULL;
+        for (j = 0; j < pool_class->count; j++) {
+            data_buff_t *data_buf = (data_buff_t *) &pool_class->storage[j * RX_POOL_WORDS(pool_class->payload_size)];
+            data_buf->next = pool_class->free_list;
+            pool_class->free_list = data_buf;
+        }
+    }
+    rx_pool_initialized = 1;
+}
+
+/*
+ * Find size class that owns the buffer, NULL if buffer is allocated from heap.
+ */
+static rx_pool_class_t *ns_sal_rx_pool_class_get(const data_buff_t *data_buf)
+{
+    uint8_t i;
+    for (i = 0; i < RX_POOL_CLASS_COUNT; i++) {
+        rx_pool_class_t *pool_class = &rx_pool_tbl[i];
+        const uint32_t *start = pool_class->storage;
+        const uint32_t *end = start + pool_class->count * RX_POOL_WORDS(pool_class->payload_size);
+        if ((const uint32_t *) data_buf >= start && (const uint32_t *) data_buf < end) {
+            return pool_class;
+        }
+    }
+    return NULL;
+}
+
+data_buff_t *ns_sal_rx_buffer_alloc(uint16_t length)
+{
+    uint8_t i;
+    data_buff_t *data_buf;
+
+    if (!rx_pool_initialized) {
+        ns_sal_rx_pool_init();
+    }
+
+    for (i = 0; i < RX_POOL_CLASS_COUNT; i++) {
+        rx_pool_class_t *pool_class = &rx_pool_tbl[i];
+        if (length <= pool_class->payload_size && NULL != pool_class->free_list) {
+            data_buf = pool_class->free_list;
+            pool_class->free_list = data_buf->next;
+            data_buf->next = NULL;
+            data_buf->size = pool_class->payload_size;
+            rx_pool_stats.alloc_count++;
+            return data_buf;
+        }
+    }
+
+    // pool exhausted or buffer too large, use heap
+    data_buf = (data_buff_t *) MALLOC(sizeof(data_buff_t) + length);
+    if (NULL != data_buf) {
+        data_buf->next = NULL;
+        data_buf->size = length;
+        rx_pool_stats.fallback_count++;
+    } else {
+        rx_pool_stats.fail_count++;
+    }
+    return data_buf;
+}
+
+void ns_sal_rx_buffer_free(data_buff_t *data_buf)
+{
+    rx_pool_class_t *pool_class = ns_sal_rx_pool_class_get(data_buf);
+
+    if (NULL != pool_class) {
+        data_buf->next = pool_class->free_list;
+        pool_class->free_list = data_buf;
+        rx_pool_stats.free_count++;
+    } else {
+        FREE(data_buf);
+    }
+}
+
+void ns_sal_rx_pool_stats_get(rx_pool_stats_t *stats)
+{
+    *stats = rx_pool_stats;
+}
+
+void ns_sal_rx_queue_init(rx_queue_t *queue)
+{
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->count = 0;
+    queue->bytes = 0;
+}
+
+void ns_sal_rx_queue_enqueue(rx_queue_t *queue, data_buff_t *data_buf)
+{
+    data_buf->next = NULL;
+    if (NULL == queue->tail) {
+        queue->head = data_buf;
+    } else {
+        queue->tail->next = data_buf;
+    }
+    queue->tail = data_buf;
+    queue->count++;
+    queue->bytes += data_buf->length;
+}
+
+data_buff_t *ns_sal_rx_queue_dequeue(rx_queue_t *queue)
+{
+    data_buff_t *data_buf = queue->head;
+    if (NULL != data_buf) {
+        queue->head = data_buf->next;
+        if (NULL == queue->head) {
+            queue->tail = NULL;
+        }
+        queue->count--;
+        queue->bytes -= data_buf->length;
+        data_buf->next = NULL;
+    }
+    return data_buf;
+}
+
+void ns_sal_rx_queue_consume(rx_queue_t *queue, uint16_t length)
+{
+    queue->head->offset += length;
+    queue->head->length -= length;
+    queue->bytes -= length;
+}
+
+uint8_t *ns_sal_rx_queue_tail_space(rx_queue_t *queue, uint16_t length)
+{
+    data_buff_t *data_buf = queue->tail;
+    if (NULL == data_buf ||
+            data_buf->offset + data_buf->length + length > data_buf->size) {
+        return NULL;
+    }
+    return &data_buf->payload[data_buf->offset + data_buf->length];
+}
+
+void ns_sal_rx_queue_tail_extend(rx_queue_t *queue, uint16_t length)
+{
+    queue->tail->length += length;
+    queue->bytes += length;
+}
+
+void ns_sal_rx_queue_destroy(rx_queue_t *queue)
+{
+    data_buff_t *data_buf;
+    while (NULL != (data_buf = ns_sal_rx_queue_dequeue(queue))) {
+        ns_sal_rx_buffer_free(data_buf);
+    }
+}
+
+static void ns_sal_tx_pool_init(void)
+{
+    uint16_t i;
+
+    tx_pool_free_list = NULL;
+    for (i = 0; i < TX_POOL_COUNT; i++) {
+        tx_buff_t *tx_buf = (tx_buff_t *) &tx_pool_storage[i * TX_POOL_WORDS];
+        tx_buf->next = tx_pool_free_list;
+        tx_pool_free_list = tx_buf;
+    }
+    tx_pool_initialized = 1;
+}
+
+/*
+ * Check if transmit buffer is taken from the pool.
+ */
+static uint8_t ns_sal_tx_pool_owns(const tx_buff_t *tx_buf)
+{
+    const uint32_t *start = tx_pool_storage;
+    const uint32_t *end = start + TX_POOL_COUNT * TX_POOL_WORDS;
+    return (const uint32_t *) tx_buf >= start && (const uint32_t *) tx_buf < end;
+}
+
+tx_buff_t *ns_sal_tx_buffer_alloc(uint16_t length)
+{
+    tx_buff_t *tx_buf = NULL;
+
+    if (!tx_pool_initialized) {
+        ns_sal_tx_pool_init();
+    }
+
+    if (length <= TX_POOL_SIZE && NULL != tx_pool_free_list) {
+        tx_buf = tx_pool_free_list;
+        tx_pool_free_list = tx_buf->next;
+    } else {
+        // pool exhausted or buffer too large, use heap
+        tx_buf = (tx_buff_t *) MALLOC(sizeof(tx_buff_t) + length);
+    }
+    if (NULL != tx_buf) {
+        tx_buf->next = NULL;
+        tx_buf->length = length;
+        tx_buf->size = length;
+        tx_buf->owned = 0;
+    }
+    return tx_buf;
+}
+
+void ns_sal_tx_buffer_free(tx_buff_t *tx_buf)
+{
+    if (NULL == tx_buf) {
+        return;
+    }
+    if (ns_sal_tx_pool_owns(tx_buf)) {
+        tx_buf->next = tx_pool_free_list;
+        tx_pool_free_list = tx_buf;
+    } else {
+        FREE(tx_buf);
+    }
+}
+
+void ns_sal_tx_queue_init(tx_queue_t *queue)
+{
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->count = 0;
+    queue->bytes = 0;
+}
+
+void ns_sal_tx_queue_enqueue(tx_queue_t *queue, tx_buff_t *tx_buf)
+{
+    tx_buf->next = NULL;
+    if (NULL == queue->tail) {
+        queue->head = tx_buf;
+    } else {
+        queue->tail->next = tx_buf;
+    }
+    queue->tail = tx_buf;
+    queue->count++;
+    queue->bytes += tx_buf->length;
+}
+
+tx_buff_t *ns_sal_tx_queue_dequeue(tx_queue_t *queue)
+{
+    tx_buff_t *tx_buf = queue->head;
+    if (NULL != tx_buf) {
+        queue->head = tx_buf->next;
+        if (NULL == queue->head) {
+            queue->tail = NULL;
+        }
+        queue->count--;
+        queue->bytes -= tx_buf->length;
+        tx_buf->next = NULL;
+    }
+    return tx_buf;
+}
+
+void ns_sal_tx_queue_destroy(tx_queue_t *queue)
+{
+    tx_buff_t *tx_buf;
+    while (NULL != (tx_buf = ns_sal_tx_queue_dequeue(queue))) {
+        ns_sal_tx_buffer_free(tx_buf);
+    }
+}
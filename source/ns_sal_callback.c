@@ -22,10 +22,13 @@
 #include <string.h> // strlen
 #include "ns_address.h"
 #include "sal/socket_api.h"
+#include "sal-iface-6lowpan/ns_sal_buffer.h"
 #include "sal-iface-6lowpan/ns_sal_callback.h"
+#include "sal-iface-6lowpan/ns_sal_utils.h"
+#include "sal-iface-6lowpan/ns_wrapper.h"
+#include "sal-iface-6lowpan/ns_sal.h"
 #include "ip6string.h"  //nanostack stoip6
-#define HAVE_DEBUG 1
-#include "ns_trace.h"
+#include "sal-iface-6lowpan/ns_sal_trace.h"
 #define TRACE_GROUP  "ns_sal_cb"
 
 //#define FUNC_ENTRY_TRACE_ENABLED
@@ -48,58 +51,395 @@ void send_socket_callback(struct socket *socket, socket_event_t *e)
     socket->event = NULL;
 }
 
+/*
+ * \brief Check if socket handler wants the event, NS_SAL_OPT_EVENT_MASK
+ * \param socket socket to be used
+ * \param event event to be sent
+ * \return 1 if event is delivered, 0 if it is skipped
+ */
+static uint8_t event_subscribed(struct socket *socket, event_flag_t event)
+{
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    return NULL == sock_data_ptr || 0 != (sock_data_ptr->event_mask & NS_SAL_EVENT_BIT(event));
+}
+
 void ns_sal_callback_name_resolved(void *context, const char *address)
 {
     socket_event_t e;
     struct socket *socket = (struct socket *) context;
+    if (!event_subscribed(socket, SOCKET_EVENT_DNS)) {
+        return;
+    }
     e.event = SOCKET_EVENT_DNS;
     e.i.d.domain = address;
     stoip6(address, strlen(address), e.i.d.addr.ipv6be);
     send_socket_callback(socket, &e);
 }
 
+/*
+ * \brief Check receive queue limit before queuing received data. Drop policies
+ * apply to datagrams only, stream data over the limit is left to NanoStack,
+ * see ns_sal_callback_rx_leave().
+ * \param socket socket that receives data
+ * \param data_buf received data
+ * \return 1 if data can be queued, 0 if data must be dropped
+ */
+static uint8_t rx_queue_admit(struct socket *socket, data_buff_t *data_buf)
+{
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    rx_queue_t *queue = &sock_data_ptr->rx_queue;
+
+    if (SOCKET_STREAM == socket->family || 0 == sock_data_ptr->rcvbuf_limit ||
+            queue->bytes + data_buf->length <= sock_data_ptr->rcvbuf_limit) {
+        return 1;
+    }
+
+    /* borrowed buffer can't be dropped, drop newest instead */
+    if (NS_SAL_RCVBUF_DROP_OLDEST == sock_data_ptr->rcvbuf_policy &&
+            0 == sock_data_ptr->rx_borrowed &&
+            data_buf->length <= sock_data_ptr->rcvbuf_limit) {
+        while (queue->bytes + data_buf->length > sock_data_ptr->rcvbuf_limit) {
+            ns_sal_rx_buffer_free(ns_sal_rx_queue_dequeue(queue));
+            sock_data_ptr->rx_dropped++;
+        }
+        return 1;
+    }
+
+    sock_data_ptr->rx_dropped++;
+    return 0;
+}
+
 void ns_sal_callback_data_received(void *context, data_buff_t *data_buf)
 {
     socket_event_t e;
-    data_buff_t *buf_tmp;
     struct socket *socket = (struct socket *) context;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    uint8_t was_empty;
+
+    e.event = SOCKET_EVENT_RX_DONE;
+    e.sock = socket;
+    e.i.e = SOCKET_ERROR_NONE;
 
     /*
      * data_buf can be NULL when we want to inform client that more data should
      *  be read from the buffer
      */
     if (NULL != data_buf) {
-        if (NULL == socket->rxBufChain) {
-            socket->rxBufChain = data_buf;
+        was_empty = (0 == sock_data_ptr->rx_queue.count && 0 == sock_data_ptr->rx_pending);
+        if (rx_queue_admit(socket, data_buf)) {
+            ns_sal_rx_queue_enqueue(&sock_data_ptr->rx_queue, data_buf);
         } else {
-            buf_tmp = (data_buff_t *) socket->rxBufChain;
-            while (NULL != buf_tmp->next) {
-                buf_tmp = buf_tmp->next;
+            tr_debug("rx queue full, datagram dropped");
+            ns_sal_rx_buffer_free(data_buf);
+            if (NS_SAL_RCVBUF_REJECT != sock_data_ptr->rcvbuf_policy) {
+                return;
             }
-            buf_tmp->next = data_buf;
+            e.event = SOCKET_EVENT_RX_ERROR;
+            e.i.e = SOCKET_ERROR_SIZE;
         }
+    } else {
+        /* data was appended to last buffer or left to NanoStack */
+        was_empty = (0 == sock_data_ptr->rx_queue.count && 1 == sock_data_ptr->rx_pending);
     }
 
-    e.event = SOCKET_EVENT_RX_DONE;
-    e.sock = socket;
-    e.i.e = SOCKET_ERROR_NONE;
+    if (SOCKET_EVENT_RX_DONE == e.event &&
+            NS_SAL_RX_NOTIFY_EDGE == sock_data_ptr->rx_notify && !was_empty) {
+        /* application has not read earlier data yet */
+        return;
+    }
+    if (!event_subscribed(socket, e.event)) {
+        return;
+    }
 
     send_socket_callback(socket, &e);
 }
 
+uint8_t ns_sal_callback_rx_leave(void *context, uint16_t length)
+{
+    struct socket *socket = (struct socket *) context;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    if (sock_data_ptr->rx_direct) {
+        return 1;
+    }
+    if (SOCKET_STREAM != socket->family) {
+        return 0;
+    }
+    /* data already left to NanoStack is read first, keep the byte order */
+    return 0 != sock_data_ptr->rx_pending ||
+           (0 != sock_data_ptr->rcvbuf_limit &&
+            sock_data_ptr->rx_queue.bytes + length > sock_data_ptr->rcvbuf_limit);
+}
+
+uint8_t *ns_sal_callback_rx_append_space(void *context, uint16_t length)
+{
+    struct socket *socket = (struct socket *) context;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    if (!sock_data_ptr->rx_coalesce ||
+            (0 != sock_data_ptr->rcvbuf_limit &&
+             sock_data_ptr->rx_queue.bytes + length > sock_data_ptr->rcvbuf_limit)) {
+        return NULL;
+    }
+    return ns_sal_rx_queue_tail_space(&sock_data_ptr->rx_queue, length);
+}
+
+void ns_sal_callback_rx_appended(void *context, uint16_t length)
+{
+    struct socket *socket = (struct socket *) context;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    if (length > 0) {
+        ns_sal_rx_queue_tail_extend(&sock_data_ptr->rx_queue, length);
+    }
+    ns_sal_callback_data_received(context, NULL);
+}
+
 /*
- * Callback from NanoStack socket, data sent.
+ * Callback from NanoStack socket, received data lost due to lack of memory.
  */
-void ns_sal_callback_tx_done(void *context, uint16_t length)
+void ns_sal_callback_rx_overrun(void *context)
 {
     socket_event_t e;
     struct socket *socket = (struct socket *) context;
-    e.event = SOCKET_EVENT_TX_DONE;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    sock_data_ptr->rx_overrun++;
+    if (!event_subscribed(socket, SOCKET_EVENT_RX_ERROR)) {
+        return;
+    }
+    e.event = SOCKET_EVENT_RX_ERROR;
+    e.i.e = SOCKET_ERROR_BAD_ALLOC;
     e.sock = socket;
-    e.i.t.sentbytes = length;
     send_socket_callback(socket, &e);
 }
 
+/*
+ * Update bytes in flight and move application owned buffers that NanoStack
+ * has finished with to completed queue.
+ * \param failed 1 if NanoStack reported send failed. Failure is reported for all
+ * data in flight, NanoStack keeps only one datagram in transmission and stream
+ * failure ends the connection.
+ */
+static void tx_sent_update(sock_data_s *sock_data_ptr, uint8_t failed)
+{
+    tx_buff_t *tx_buf;
+
+    if (failed) {
+        while (NULL != (tx_buf = ns_sal_tx_queue_dequeue(&sock_data_ptr->tx_wait))) {
+            tx_buf->status = SOCKET_ERROR_UNKNOWN;
+            ns_sal_tx_queue_enqueue(&sock_data_ptr->tx_complete, tx_buf);
+        }
+        sock_data_ptr->tx_seq_done = sock_data_ptr->tx_seq_sent;
+        return;
+    }
+
+    if ((int32_t)(sock_data_ptr->tx_seq_sent - sock_data_ptr->tx_seq_done) < 0) {
+        /* NanoStack reported more than SAL passed to it */
+        sock_data_ptr->tx_seq_done = sock_data_ptr->tx_seq_sent;
+    }
+    while (NULL != (tx_buf = sock_data_ptr->tx_wait.head) &&
+            (int32_t)(sock_data_ptr->tx_seq_done - tx_buf->seq) >= 0) {
+        ns_sal_tx_queue_dequeue(&sock_data_ptr->tx_wait);
+        tx_buf->status = SOCKET_ERROR_NONE;
+        ns_sal_tx_queue_enqueue(&sock_data_ptr->tx_complete, tx_buf);
+    }
+}
+
+/* number of sockets with non-zero transmit priority */
+static uint8_t tx_priority_sockets = 0;
+/* set when a socket was held by higher priority, cleared when all are released */
+static uint8_t tx_priority_held = 0;
+
+void ns_sal_tx_priority_set(void *context, uint8_t priority)
+{
+    struct socket *socket = (struct socket *) context;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    if (0 == sock_data_ptr->tx_priority && 0 != priority) {
+        tx_priority_sockets++;
+    } else if (0 != sock_data_ptr->tx_priority && 0 == priority) {
+        tx_priority_sockets--;
+    }
+    sock_data_ptr->tx_priority = priority;
+}
+
+/*
+ * Check if a socket with higher priority has data queued or in flight. No socket
+ * can be higher than the default priority 0 if none has priority set.
+ */
+uint8_t ns_sal_tx_priority_blocked(uint8_t priority)
+{
+    int8_t socket_id;
+
+    if (NS_SAL_PRIORITY_MAX == priority || 0 == tx_priority_sockets) {
+        return 0;
+    }
+    for (socket_id = 0; socket_id < NS_WRAPPER_SOCKETS_MAX; socket_id++) {
+        struct socket *socket = ns_wrapper_socket_context_get(socket_id);
+        sock_data_s *sock_data_ptr;
+        if (NULL == socket || NULL == socket->impl) {
+            continue;
+        }
+        sock_data_ptr = (sock_data_s *) socket->impl;
+        if (sock_data_ptr->tx_priority > priority &&
+                (sock_data_ptr->tx_in_flight || sock_data_ptr->tx_queue.count > 0)) {
+            tx_priority_held = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Send queued data now that NanoStack has finished previous send.
+ * Sending stops when NanoStack becomes busy again (-4).
+ */
+static void tx_queue_drain(struct socket *socket)
+{
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+    tx_buff_t *tx_buf;
+    int8_t status;
+
+    while (NULL != (tx_buf = sock_data_ptr->tx_queue.head)) {
+        if (!ns_sal_tx_pace_ready(socket, tx_buf->length)) {
+            /* released later from periodic task */
+            break;
+        }
+        if (ns_sal_tx_priority_blocked(sock_data_ptr->tx_priority)) {
+            /* released when higher priority sockets are done */
+            break;
+        }
+        status = ns_wrapper_socket_send_buffer(sock_data_ptr, tx_buf);
+        if (-4 == status) {
+            break;
+        }
+
+        ns_sal_tx_queue_dequeue(&sock_data_ptr->tx_queue);
+        sock_data_ptr->tx_latency_last = ns_sal_time_us() - tx_buf->queued_at;
+        if (sock_data_ptr->tx_latency_last > sock_data_ptr->tx_latency_max) {
+            sock_data_ptr->tx_latency_max = sock_data_ptr->tx_latency_last;
+        }
+        if (!tx_buf->owned) {
+            ns_sal_tx_buffer_free(tx_buf);
+        } else if (0 == status) {
+            tx_buf->seq = sock_data_ptr->tx_seq_sent;
+            ns_sal_tx_queue_enqueue(&sock_data_ptr->tx_wait, tx_buf);
+        } else {
+            tx_buf->status = SOCKET_ERROR_UNKNOWN;
+            ns_sal_tx_queue_enqueue(&sock_data_ptr->tx_complete, tx_buf);
+        }
+
+        if (0 != status) {
+            tr_error("queued send failed: %d", status);
+            ns_sal_callback_tx_error(socket);
+            if (NULL == socket->impl) {
+                /* socket destroyed in callback */
+                return;
+            }
+        }
+    }
+}
+
+/*
+ * Send queued data of all sockets, highest priority first. Lower priority
+ * sockets stay held while higher priority data is queued or in flight.
+ * \param socket socket that finished sending, or was closed
+ */
+static void tx_schedule(struct socket *socket)
+{
+    uint8_t pending = 0;
+    int8_t socket_id;
+    int8_t priority;
+
+    if (0 == tx_priority_sockets && !tx_priority_held) {
+        /* no socket is held by another, only this one may continue */
+        if (NULL != socket && NULL != socket->impl && !((sock_data_s *) socket->impl)->tx_in_flight &&
+                ((sock_data_s *) socket->impl)->tx_queue.count > 0) {
+            tx_queue_drain(socket);
+        }
+        return;
+    }
+    if (0 == tx_priority_sockets) {
+        /* sockets held earlier are released by this scan, none can be held again */
+        tx_priority_held = 0;
+    }
+
+    for (socket_id = 0; socket_id < NS_WRAPPER_SOCKETS_MAX; socket_id++) {
+        struct socket *other = ns_wrapper_socket_context_get(socket_id);
+        if (NULL != other && NULL != other->impl &&
+                ((sock_data_s *) other->impl)->tx_queue.count > 0) {
+            pending |= 1 << ((sock_data_s *) other->impl)->tx_priority;
+        }
+    }
+
+    for (priority = NS_SAL_PRIORITY_MAX; priority >= 0 && pending; priority--) {
+        if (!(pending & (1 << priority))) {
+            continue;
+        }
+        pending &= ~(1 << priority);
+        for (socket_id = 0; socket_id < NS_WRAPPER_SOCKETS_MAX; socket_id++) {
+            struct socket *other = ns_wrapper_socket_context_get(socket_id);
+            sock_data_s *sock_data_ptr;
+            if (NULL == other || NULL == other->impl) {
+                continue;
+            }
+            sock_data_ptr = (sock_data_s *) other->impl;
+            if (sock_data_ptr->tx_priority == priority && !sock_data_ptr->tx_in_flight &&
+                    sock_data_ptr->tx_queue.count > 0) {
+                tx_queue_drain(other);
+            }
+        }
+    }
+}
+
+/*
+ * Callback from NanoStack socket, data sent.
+ */
+void ns_sal_callback_tx_done(void *context, uint16_t length)
+{
+    socket_event_t e;
+    struct socket *socket = (struct socket *) context;
+    tx_sent_update((sock_data_s *) socket->impl, 0);
+    tx_queue_drain(socket);
+    if (NULL == socket->impl) {
+        return;
+    }
+    ns_sal_tx_coalesce_resume(socket);
+    if (event_subscribed(socket, SOCKET_EVENT_TX_DONE)) {
+        e.event = SOCKET_EVENT_TX_DONE;
+        e.sock = socket;
+        e.i.t.sentbytes = length;
+        send_socket_callback(socket, &e);
+    }
+    // lower priority sockets may continue
+    tx_schedule(socket);
+}
+
+void ns_sal_callback_tx_ready(void *context)
+{
+    struct socket *socket = (struct socket *) context;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    if (NULL != sock_data_ptr && !sock_data_ptr->tx_in_flight) {
+        /* otherwise rest of the queue is sent when NanoStack reports send done */
+        tx_queue_drain(socket);
+    }
+    tx_schedule(socket);
+}
+
+void ns_sal_callback_tx_closed(void *context)
+{
+    struct socket *socket = (struct socket *) context;
+    sock_data_s *sock_data_ptr = (sock_data_s *) socket->impl;
+
+    if (NULL != sock_data_ptr) {
+        /* no TX_DONE follows for data in flight */
+        sock_data_ptr->tx_in_flight = 0;
+    }
+    tx_schedule(socket);
+}
+
 /*
  * Callback from NanoStack socket, data sending error.
  */
@@ -107,18 +447,47 @@ void ns_sal_callback_tx_error(void *context)
 {
     socket_event_t e;
     struct socket *socket = (struct socket *) context;
+    if (!event_subscribed(socket, SOCKET_EVENT_TX_ERROR)) {
+        return;
+    }
     e.event = SOCKET_EVENT_TX_ERROR;
     e.i.e = SOCKET_ERROR_UNKNOWN;
     e.sock = socket;
     send_socket_callback(socket, &e);
 }
 
+/*
+ * Callback from NanoStack socket, send failed. NanoStack is ready for next send.
+ */
+void ns_sal_callback_tx_failed(void *context)
+{
+    socket_event_t e;
+    struct socket *socket = (struct socket *) context;
+    tx_sent_update((sock_data_s *) socket->impl, 1);
+    tx_queue_drain(socket);
+    if (NULL == socket->impl) {
+        return;
+    }
+    ns_sal_tx_coalesce_resume(socket);
+    if (event_subscribed(socket, SOCKET_EVENT_TX_ERROR)) {
+        e.event = SOCKET_EVENT_TX_ERROR;
+        e.i.e = SOCKET_ERROR_UNKNOWN;
+        e.sock = socket;
+        send_socket_callback(socket, &e);
+    }
+    // lower priority sockets may continue
+    tx_schedule(socket);
+}
+
 void ns_sal_callback_connect(void *context)
 {
     socket_event_t e;
     struct socket *socket = (struct socket *) context;
-    e.event = SOCKET_EVENT_CONNECT;
     socket->status |= SOCKET_STATUS_CONNECTED;
+    if (!event_subscribed(socket, SOCKET_EVENT_CONNECT)) {
+        return;
+    }
+    e.event = SOCKET_EVENT_CONNECT;
     e.sock = socket;
     send_socket_callback(socket, &e);
 }
@@ -127,8 +496,13 @@ void ns_sal_callback_disconnect(void *context)
 {
     socket_event_t e;
     struct socket *socket = (struct socket *) context;
-    e.event = SOCKET_EVENT_DISCONNECT;
     socket->status &= ~SOCKET_STATUS_CONNECTED;
+    // lower priority sockets may continue
+    tx_schedule(socket);
+    if (!event_subscribed(socket, SOCKET_EVENT_DISCONNECT)) {
+        return;
+    }
+    e.event = SOCKET_EVENT_DISCONNECT;
     e.sock = socket;
     send_socket_callback(socket, &e);
 }
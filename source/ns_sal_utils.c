@@ -21,6 +21,7 @@
 #include <string.h> // memcpy
 #include "ns_address.h"
 #include "sal/socket_api.h"
+#include "mbed-hal/us_ticker_api.h"
 #include "sal-iface-6lowpan/ns_sal_utils.h"
 
 void convert_mbed_addr_to_ns(ns_address_t *ns_addr,
@@ -37,3 +38,8 @@ void convert_ns_addr_to_mbed(struct socket_addr *s_addr, const ns_address_t *ns_
     *port = ns_addr->identifier;
     memcpy(s_addr->ipv6be, ns_addr->address, 16);
 }
+
+uint32_t ns_sal_time_us(void)
+{
+    return us_ticker_read();
+}
@@ -17,14 +17,17 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
-#include "nsdynmemLIB.h"
+#include <string.h> // memset
 #include "ip6string.h"  //ip6tos
 #include "ns_address.h"
 #include "net_interface.h"
 #include "socket_api.h" // nanostack socket api
-#define HAVE_DEBUG 1
-#include "ns_trace.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "sal-iface-6lowpan/ns_sal_trace.h"
+#include "sal-iface-6lowpan/ns_sal_buffer.h"
 #include "sal-iface-6lowpan/ns_sal_callback.h"
+#include "sal-iface-6lowpan/ns_sal_utils.h"
 #include "sal-iface-6lowpan/ns_wrapper.h"
 
 // For tracing we need to define define group
@@ -38,60 +41,124 @@
 #define FUNC_ENTRY_TRACE(...)
 #endif
 
-#define NS_WRAPPER_SOCKETS_MAX  16  //same as NanoStack SOCKET_MAX
-#define MALLOC  ns_dyn_mem_alloc
-#define FREE    ns_dyn_mem_free
+// socket handle table entry, indexed by NanoStack socket ID
+typedef struct _socket_handle_entry_t {
+    void *context;              /*!< context of open socket, NULL if slot is free */
+    uint16_t generation;        /*!< incremented when socket is freed */
+    sock_data_s sock_data;      /*!< socket data, no heap is used on socket create */
+} socket_handle_entry_t;
 
-// table for socket contexts
-typedef struct _socket_context_map_t {
-    void *context;
-} socket_context_map_t;
+static socket_handle_entry_t socket_handle_tbl[NS_WRAPPER_SOCKETS_MAX];
 
-static socket_context_map_t socket_context_tbl[NS_WRAPPER_SOCKETS_MAX] = {{0}};
+/*
+ * Deferred event dispatch, configurable via yotta config sal-iface-6lowpan.event-queue.size/budget.
+ * With size 0 socket handlers are called directly from the NanoStack socket callback.
+ * Otherwise events are queued to a ring and dispatched from an event tasklet,
+ * at most budget events per tasklet run.
+ */
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE    YOTTA_CFG_SAL_IFACE_6LOWPAN_EVENT_QUEUE_SIZE
+#else
+#define EVENT_QUEUE_SIZE    0
+#endif
+#ifdef YOTTA_CFG_SAL_IFACE_6LOWPAN_EVENT_QUEUE_BUDGET
+#define EVENT_QUEUE_BUDGET  YOTTA_CFG_SAL_IFACE_6LOWPAN_EVENT_QUEUE_BUDGET
+#else
+#define EVENT_QUEUE_BUDGET  4
+#endif
+
+#define EVENT_QUEUE_DRAIN   1   // tasklet event type for dispatching queued events
+
+// queued socket event
+typedef struct _socket_event_entry_t {
+    ns_wrapper_handle_t handle; /*!< handle of the socket when event was queued */
+    uint8_t event_type;         /*!< NanoStack socket event */
+    int8_t interface_id;        /*!< interface of the event */
+    uint16_t d_len;             /*!< data length of the event */
+    uint32_t queued_at;         /*!< time when event was queued, microseconds */
+} socket_event_entry_t;
+
+#if EVENT_QUEUE_SIZE
+static socket_event_entry_t event_queue[EVENT_QUEUE_SIZE];
+static uint16_t event_queue_head;           // next event to dispatch
+static uint16_t event_queue_count;          // number of queued events
+static uint8_t event_queue_drain_pending;   // drain event sent to tasklet
+static int8_t event_queue_tasklet = -1;
+#endif
+static ns_wrapper_event_stats_t event_stats;
+
+#define TX_TIMER_EVENT      2   // tasklet event type and timer ID of SAL transmit timer
+static int8_t tx_timer_tasklet = -1;
+
+/*
+ * Get table entry of open socket, NULL if socket ID is not in use.
+ */
+static socket_handle_entry_t *ns_wrapper_handle_entry(int8_t socket_id)
+{
+    if ((uint8_t) socket_id >= NS_WRAPPER_SOCKETS_MAX ||
+            NULL == socket_handle_tbl[socket_id].context) {
+        return NULL;
+    }
+    return &socket_handle_tbl[socket_id];
+}
 
 /**** Private functions ****/
 
 /*
  * Handler for the received data
  */
-void ns_wrapper_data_received(socket_callback_t *sock_cb)
+static void ns_wrapper_data_received(socket_handle_entry_t *entry, socket_callback_t *sock_cb)
 {
     if (sock_cb->d_len > 0) {
-        data_buff_t *recv_buff = (data_buff_t *) MALLOC(
-                                     sizeof(data_buff_t) + sock_cb->d_len);
+        sock_data_s *sock_data_ptr = &entry->sock_data;
+        if (ns_sal_callback_rx_leave(entry->context, sock_cb->d_len)) {
+            // data is read from NanoStack when application reads it
+            if (sock_data_ptr->rx_pending < 0xffff) {
+                sock_data_ptr->rx_pending++;
+            }
+            ns_sal_callback_data_received(entry->context, NULL);
+            return;
+        }
+
+        // append stream data to the space left in the last buffer
+        uint8_t *tail_space = ns_sal_callback_rx_append_space(entry->context, sock_cb->d_len);
+        if (NULL != tail_space) {
+            ns_address_t ns_address;
+            int16_t length = socket_read(sock_cb->socket_id, &ns_address, tail_space, sock_cb->d_len);
+            ns_sal_callback_rx_appended(entry->context, (length > 0) ? length : 0);
+            return;
+        }
+
+        data_buff_t *recv_buff = ns_sal_rx_buffer_alloc(sock_cb->d_len);
         if (NULL != recv_buff) {
             int16_t length = socket_read(sock_cb->socket_id,
                                          &recv_buff->ns_address, recv_buff->payload,
                                          sock_cb->d_len);
             recv_buff->length = length;
-            recv_buff->next = NULL;
+            recv_buff->offset = 0;
 
-            ns_sal_callback_data_received(socket_context_tbl[sock_cb->socket_id].context, recv_buff);
+            ns_sal_callback_data_received(entry->context, recv_buff);
             // allocated memory will be deallocated when application reads the data or when socket is closed
         } else {
             tr_error("data_buff_t alloc failed!");
+            ns_sal_callback_rx_overrun(entry->context);
         }
     }
 }
 
 /*
- * Socket callback, called automatically by the NanoStack when event occurs.
+ * Deliver NanoStack socket event to the socket
  */
-void ns_wrapper_socket_callback(void *cb)
+static void ns_wrapper_event_dispatch(socket_handle_entry_t *entry, socket_callback_t *sock_cb)
 {
-    socket_callback_t *sock_cb = (socket_callback_t *) cb;
-
-    FUNC_ENTRY_TRACE("socket_callback() sock=%d, event=%d, interface=%d, data len=%d",
-                     sock_cb->socket_id, sock_cb->event_type, sock_cb->interface_id, sock_cb->d_len);
-
     switch (sock_cb->event_type) {
         case SOCKET_DATA:
             tr_debug("SOCKET_DATA, sock=%d, bytes=%d", sock_cb->socket_id, sock_cb->d_len);
-            ns_wrapper_data_received(sock_cb);
+            ns_wrapper_data_received(entry, sock_cb);
             break;
         case SOCKET_BIND_DONE:
             tr_debug("SOCKET_BIND_DONE");
-            ns_sal_callback_connect(socket_context_tbl[sock_cb->socket_id].context);
+            ns_sal_callback_connect(entry->context);
             break;
         case SOCKET_BIND_FAIL: // Not used in NS
             tr_debug("SOCKET_BIND_FAIL");
@@ -104,40 +171,238 @@ void ns_wrapper_socket_callback(void *cb)
             break;
         case SOCKET_TX_FAIL:
             tr_debug("SOCKET_TX_FAIL");
-            ns_sal_callback_tx_error(socket_context_tbl[sock_cb->socket_id].context);
+            entry->sock_data.tx_in_flight = 0;
+            ns_sal_callback_tx_failed(entry->context);
             break;
         case SOCKET_CONNECT_CLOSED:
             tr_debug("SOCKET_CONNECT_CLOSED");
-            ns_sal_callback_disconnect(socket_context_tbl[sock_cb->socket_id].context);
+            entry->sock_data.tx_in_flight = 0;
+            ns_sal_callback_disconnect(entry->context);
             break;
         case SOCKET_CONNECT_FAIL_CLOSED: // Not used in NS
             tr_debug("SOCKET_CONNECT_FAIL_CLOSED");
             break;
         case SOCKET_NO_ROUTE:
             tr_debug("SOCKET_NO_ROUTE");
-            ns_sal_callback_tx_error(socket_context_tbl[sock_cb->socket_id].context);
+            entry->sock_data.tx_in_flight = 0;
+            ns_sal_callback_tx_failed(entry->context);
             break;
         case SOCKET_TX_DONE:
             tr_debug("SOCKET_TX_DONE, %d bytes sent", sock_cb->d_len);
-            ns_sal_callback_tx_done(socket_context_tbl[sock_cb->socket_id].context, sock_cb->d_len);
+            entry->sock_data.tx_in_flight = 0;
+            entry->sock_data.tx_seq_done += sock_cb->d_len;
+            ns_sal_callback_tx_done(entry->context, sock_cb->d_len);
+            break;
+        case SOCKET_NO_RAM:
+            // NanoStack could not buffer received data
+            tr_debug("SOCKET_NO_RAM");
+            ns_sal_callback_rx_overrun(entry->context);
             break;
         default:
-            // SOCKET_NO_RAM, error case for SOCKET_TX_DONE
-            ns_sal_callback_tx_error(socket_context_tbl[sock_cb->socket_id].context);
+            // error case for SOCKET_TX_DONE
+            ns_sal_callback_tx_error(entry->context);
             break;
     }
 }
 
-void ns_wrapper_release_socket_data(sock_data_s *sock_data_ptr)
+#if EVENT_QUEUE_SIZE
+/*
+ * Dispatch queued events in queuing order
+ * \param budget maximum number of events to dispatch
+ */
+static void ns_wrapper_event_queue_drain(uint16_t budget)
+{
+    while (event_queue_count > 0 && budget-- > 0) {
+        socket_event_entry_t event = event_queue[event_queue_head];
+        socket_callback_t sock_cb;
+        uint32_t latency;
+        uint32_t start;
+
+        // remove before dispatch, handler may cause new events to be queued
+        event_queue_head = (event_queue_head + 1) % EVENT_QUEUE_SIZE;
+        event_queue_count--;
+
+        if (NULL == ns_wrapper_socket_context_lookup(event.handle)) {
+            // socket was freed, or socket ID reused, after event was queued
+            tr_debug("stale event %d for socket %d dropped", event.event_type, NS_WRAPPER_HANDLE_ID(event.handle));
+            event_stats.stale++;
+            continue;
+        }
+
+        memset(&sock_cb, 0, sizeof(sock_cb));
+        sock_cb.event_type = event.event_type;
+        sock_cb.socket_id = NS_WRAPPER_HANDLE_ID(event.handle);
+        sock_cb.interface_id = event.interface_id;
+        sock_cb.d_len = event.d_len;
+
+        start = ns_sal_time_us();
+        latency = start - event.queued_at;
+        if (latency > event_stats.latency_max) {
+            event_stats.latency_max = latency;
+        }
+        ns_wrapper_event_dispatch(&socket_handle_tbl[sock_cb.socket_id], &sock_cb);
+        latency = ns_sal_time_us() - start;
+        if (latency > event_stats.handler_max) {
+            event_stats.handler_max = latency;
+        }
+        event_stats.dispatched++;
+    }
+}
+
+/*
+ * Request tasklet to dispatch queued events
+ * \return 0 on success, -1 if event could not be sent
+ */
+static int8_t ns_wrapper_event_queue_schedule(void)
+{
+    arm_event_s event = {
+        .receiver = event_queue_tasklet,
+        .sender = event_queue_tasklet,
+        .event_type = EVENT_QUEUE_DRAIN,
+        .event_id = 0,
+        .data_ptr = NULL,
+        .priority = ARM_LIB_LOW_PRIORITY_EVENT, // let NanoStack events run first
+        .event_data = 0,
+    };
+
+    if (event_queue_drain_pending) {
+        return 0;
+    }
+    if (0 != eventOS_event_send(&event)) {
+        return -1;
+    }
+    event_queue_drain_pending = 1;
+    return 0;
+}
+
+/*
+ * Event queue tasklet, dispatches a budget of events per run
+ */
+static void ns_wrapper_event_tasklet(arm_event_s *event)
+{
+    if (EVENT_QUEUE_DRAIN != event->event_type) {
+        return;
+    }
+    event_queue_drain_pending = 0;
+    event_stats.passes++;
+    ns_wrapper_event_queue_drain(EVENT_QUEUE_BUDGET);
+    if (event_queue_count > 0 && 0 != ns_wrapper_event_queue_schedule()) {
+        tr_error("event queue schedule failed");
+        ns_wrapper_event_queue_drain(EVENT_QUEUE_SIZE);
+    }
+}
+
+/*
+ * Queue NanoStack socket event for dispatching from tasklet
+ * \return 1 if event was queued, 0 if event must be dispatched directly
+ */
+static uint8_t ns_wrapper_event_queue_put(socket_handle_entry_t *entry, socket_callback_t *sock_cb)
+{
+    socket_event_entry_t *event;
+
+    if (event_queue_tasklet < 0) {
+        return 0;
+    }
+
+    if (EVENT_QUEUE_SIZE == event_queue_count) {
+        // ring full, dispatch queued events here to keep the order of events
+        event_stats.overflow++;
+        ns_wrapper_event_queue_drain(EVENT_QUEUE_SIZE);
+    }
+
+    event = &event_queue[(event_queue_head + event_queue_count) % EVENT_QUEUE_SIZE];
+    event->handle = entry->sock_data.handle;
+    event->event_type = sock_cb->event_type;
+    event->interface_id = sock_cb->interface_id;
+    event->d_len = sock_cb->d_len;
+    event->queued_at = ns_sal_time_us();
+    event_queue_count++;
+    event_stats.queued++;
+    if (event_queue_count > event_stats.depth_max) {
+        event_stats.depth_max = event_queue_count;
+    }
+
+    if (0 != ns_wrapper_event_queue_schedule()) {
+        tr_error("event queue schedule failed");
+        ns_wrapper_event_queue_drain(EVENT_QUEUE_SIZE);
+    }
+    return 1;
+}
+#endif
+
+/*
+ * SAL transmit timer tasklet
+ */
+static void ns_wrapper_tx_timer_tasklet(arm_event_s *event)
+{
+    if (TX_TIMER_EVENT != event->event_type) {
+        return;
+    }
+    ns_sal_tx_timer_expired();
+}
+
+int8_t ns_wrapper_tx_timer_start(uint32_t delay_ms)
+{
+    if (tx_timer_tasklet < 0) {
+        tx_timer_tasklet = eventOS_event_handler_create(ns_wrapper_tx_timer_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+        if (tx_timer_tasklet < 0) {
+            return -1;
+        }
+    }
+    // only one timer is kept running
+    eventOS_event_timer_cancel(TX_TIMER_EVENT, tx_timer_tasklet);
+    if (0 != eventOS_event_timer_request(TX_TIMER_EVENT, TX_TIMER_EVENT, tx_timer_tasklet, delay_ms)) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Socket callback, called automatically by the NanoStack when event occurs.
+ */
+void ns_wrapper_socket_callback(void *cb)
+{
+    socket_callback_t *sock_cb = (socket_callback_t *) cb;
+    socket_handle_entry_t *entry;
+
+    FUNC_ENTRY_TRACE("socket_callback() sock=%d, event=%d, interface=%d, data len=%d",
+                     sock_cb->socket_id, sock_cb->event_type, sock_cb->interface_id, sock_cb->d_len);
+
+    entry = ns_wrapper_handle_entry(sock_cb->socket_id);
+    if (NULL == entry) {
+        // late event of a freed socket
+        tr_debug("event %d for closed socket %d dropped", sock_cb->event_type, sock_cb->socket_id);
+        return;
+    }
+
+#if EVENT_QUEUE_SIZE
+    if (ns_wrapper_event_queue_put(entry, sock_cb)) {
+        return;
+    }
+#endif
+    ns_wrapper_event_dispatch(entry, sock_cb);
+}
+
+void ns_wrapper_event_stats_get(ns_wrapper_event_stats_t *stats)
+{
+    *stats = event_stats;
+}
+
+void ns_wrapper_event_stats_reset(void)
 {
-    FREE(sock_data_ptr);
+    memset(&event_stats, 0, sizeof(event_stats));
 }
 
 int8_t ns_wrapper_socket_free(sock_data_s *sock_data_ptr)
 {
     tr_debug("ns_wrapper_socket_free(%d)", sock_data_ptr->socket_id);
     int8_t retval = socket_free(sock_data_ptr->socket_id);
-    ns_wrapper_release_socket_data(sock_data_ptr);
+    if ((uint8_t) sock_data_ptr->socket_id < NS_WRAPPER_SOCKETS_MAX) {
+        socket_handle_entry_t *entry = &socket_handle_tbl[sock_data_ptr->socket_id];
+        // invalidate handles of this socket
+        entry->context = NULL;
+        entry->generation++;
+    }
     return retval;
 }
 
@@ -149,27 +414,65 @@ sock_data_s *ns_wrapper_socket_open(int8_t socket_type, int8_t identifier, void
         protocol = SOCKET_UDP;
     }
 
-    sock_data_s *sock_data_ptr = (sock_data_s *) MALLOC(sizeof(sock_data_s));
-    if (NULL != sock_data_ptr) {
-        sock_data_ptr->socket_id = socket_open(protocol, identifier,
-                                               ns_wrapper_socket_callback);
-        if ((sock_data_ptr->socket_id >= 0) &&
-                (sock_data_ptr->socket_id < NS_WRAPPER_SOCKETS_MAX)) {
-            sock_data_ptr->security_session_id = 0;
-            // save context to table so that callbacks can be made to right socket
-            socket_context_tbl[sock_data_ptr->socket_id].context = context;
-            tr_debug("ns_wrapper_socket_open(%d)", sock_data_ptr->socket_id);
-        } else {
-            /* socket opening failed, free reserved data */
-            tr_error("sock_data_s alloc failed");
-            FREE(sock_data_ptr);
-            sock_data_ptr = NULL;
+#if EVENT_QUEUE_SIZE
+    if (event_queue_tasklet < 0) {
+        event_queue_tasklet = eventOS_event_handler_create(ns_wrapper_event_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+        if (event_queue_tasklet < 0) {
+            // events are dispatched directly from NanoStack socket callback
+            tr_error("event queue tasklet create failed: %d", event_queue_tasklet);
         }
     }
+#endif
+
+    int8_t socket_id = socket_open(protocol, identifier, ns_wrapper_socket_callback);
+    if (socket_id < 0) {
+        tr_error("socket_open failed: %d", socket_id);
+        return NULL;
+    }
+    if (socket_id >= NS_WRAPPER_SOCKETS_MAX) {
+        tr_error("socket ID %d does not fit to handle table", socket_id);
+        socket_free(socket_id);
+        return NULL;
+    }
+
+    // save context to table so that callbacks can be made to right socket
+    socket_handle_entry_t *entry = &socket_handle_tbl[socket_id];
+    sock_data_s *sock_data_ptr = &entry->sock_data;
+    entry->context = context;
+    sock_data_ptr->socket_id = socket_id;
+    sock_data_ptr->handle = ((ns_wrapper_handle_t) entry->generation << 8) | socket_id;
+    sock_data_ptr->security_session_id = 0;
+    ns_sal_rx_queue_init(&sock_data_ptr->rx_queue);
+    ns_sal_tx_queue_init(&sock_data_ptr->tx_queue);
+    ns_sal_tx_queue_init(&sock_data_ptr->tx_wait);
+    ns_sal_tx_queue_init(&sock_data_ptr->tx_complete);
+    sock_data_ptr->tx_seq_sent = 0;
+    sock_data_ptr->tx_seq_done = 0;
+    tr_debug("ns_wrapper_socket_open(%d)", socket_id);
 
     return sock_data_ptr;
 }
 
+void *ns_wrapper_socket_context_get(int8_t socket_id)
+{
+    if ((uint8_t) socket_id >= NS_WRAPPER_SOCKETS_MAX) {
+        return NULL;
+    }
+    return socket_handle_tbl[socket_id].context;
+}
+
+void *ns_wrapper_socket_context_lookup(ns_wrapper_handle_t handle)
+{
+    socket_handle_entry_t *entry;
+
+    if ((uint8_t) NS_WRAPPER_HANDLE_ID(handle) >= NS_WRAPPER_SOCKETS_MAX) {
+        return NULL;
+    }
+    entry = &socket_handle_tbl[NS_WRAPPER_HANDLE_ID(handle)];
+    // context of freed socket is NULL
+    return (entry->generation == NS_WRAPPER_HANDLE_GEN(handle)) ? entry->context : NULL;
+}
+
 int8_t ns_wrapper_socket_bind(sock_data_s *sock_data_ptr, ns_address_t *address)
 {
     FUNC_ENTRY_TRACE("ns_wrapper_socket_bind() sock=%d", sock_data_ptr->socket_id);
@@ -189,15 +492,64 @@ int8_t ns_wrapper_socket_connect(sock_data_s *sock_data_ptr, ns_address_t *addre
     return socket_connect(sock_data_ptr->socket_id, address, 0);
 }
 
+int16_t ns_wrapper_socket_read(sock_data_s *sock_data_ptr, ns_address_t *address, uint8_t *buffer, uint16_t length)
+{
+    FUNC_ENTRY_TRACE("ns_wrapper_socket_read: sock_id=%d, length=%d", sock_data_ptr->socket_id, length);
+    return socket_read(sock_data_ptr->socket_id, address, buffer, length);
+}
+
 int8_t ns_wrapper_socket_send(sock_data_s *sock_data_ptr, uint8_t *buffer, uint16_t length)
 {
     FUNC_ENTRY_TRACE("ns_wrapper_socket_send: sock_id=%d, length=%d", sock_data_ptr->socket_id, length);
-    return socket_send(sock_data_ptr->socket_id, buffer, length);
+    int8_t status = socket_send(sock_data_ptr->socket_id, buffer, length);
+    if (0 == status) {
+        sock_data_ptr->tx_in_flight = 1;
+        sock_data_ptr->tx_seq_sent += length;
+        if (sock_data_ptr->tx_pace_rate > 0) {
+            sock_data_ptr->tx_pace_tokens -= length;
+        }
+    }
+    return status;
 }
 
 int8_t ns_wrapper_socket_send_to(sock_data_s *sock_data_ptr, ns_address_t *addr, uint8_t *buffer, uint16_t length)
 {
     FUNC_ENTRY_TRACE("ns_wrapper_socket_send_to: sock_id=%d, length=%d, port=%d", sock_data_ptr->socket_id, length, addr->identifier);
-    return socket_sendto(sock_data_ptr->socket_id, addr, buffer, length);
+    int8_t status = socket_sendto(sock_data_ptr->socket_id, addr, buffer, length);
+    if (0 == status) {
+        sock_data_ptr->tx_in_flight = 1;
+        sock_data_ptr->tx_seq_sent += length;
+        if (sock_data_ptr->tx_pace_rate > 0) {
+            sock_data_ptr->tx_pace_tokens -= length;
+        }
+    }
+    return status;
 }
 
+int8_t ns_wrapper_socket_send_buffer(sock_data_s *sock_data_ptr, tx_buff_t *tx_buf)
+{
+    if (tx_buf->use_address) {
+        return ns_wrapper_socket_send_to(sock_data_ptr, &tx_buf->ns_address, tx_buf->payload, tx_buf->length);
+    }
+    return ns_wrapper_socket_send(sock_data_ptr, tx_buf->payload, tx_buf->length);
+}
+
+int8_t ns_wrapper_socket_tclass_set(sock_data_s *sock_data_ptr, uint8_t tclass)
+{
+    int16_t value = tclass;
+    FUNC_ENTRY_TRACE("ns_wrapper_socket_tclass_set: sock_id=%d, tclass=%d", sock_data_ptr->socket_id, tclass);
+    return socket_setsockopt(sock_data_ptr->socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_TCLASS, &value, sizeof(value));
+}
+
+int8_t ns_wrapper_socket_flow_label_set(sock_data_s *sock_data_ptr, uint32_t flow_label)
+{
+#ifdef SOCKET_IPV6_FLOW_LABEL
+    int32_t value = flow_label;
+    FUNC_ENTRY_TRACE("ns_wrapper_socket_flow_label_set: sock_id=%d, flow_label=%lx", sock_data_ptr->socket_id, (unsigned long) flow_label);
+    return socket_setsockopt(sock_data_ptr->socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_FLOW_LABEL, &value, sizeof(value));
+#else
+    (void) sock_data_ptr;
+    (void) flow_label;
+    return -1;
+#endif
+}
@@ -26,6 +26,13 @@
 #include "mbed-drivers/Timeout.h"
 #include "mbed-drivers/Ticker.h"
 #include "mbed-drivers/mbed.h"
+#include "ns_address.h"
+#include "sal-iface-6lowpan/ns_sal.h"
+#include "sal-iface-6lowpan/ns_sal_buffer.h"
+#include "sal-iface-6lowpan/ns_wrapper.h"
+extern "C" {
+#include "sal-iface-6lowpan/ns_sal_callback.h"
+}
 #include "test_cases.h"
 
 //#define TEST_DEBUG
@@ -2134,3 +2141,2050 @@ int ns_socket_test_unimplemented_apis(socket_stack_t stack)
 
     TEST_RETURN();
 }
+
+static volatile int rcvbuf_rx_done_count;
+static volatile int rcvbuf_rx_error_count;
+static volatile socket_error_t rcvbuf_rx_error;
+static void rcvbuf_socket_cb()
+{
+    switch (client_socket->event->event) {
+        case SOCKET_EVENT_RX_DONE:
+            rcvbuf_rx_done_count++;
+            break;
+        case SOCKET_EVENT_RX_ERROR:
+            rcvbuf_rx_error_count++;
+            rcvbuf_rx_error = client_socket->event->i.e;
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Queue datagram to socket as if it was received from the stack
+ */
+static void rcvbuf_inject_datagram(struct socket *sock, uint8_t value, uint16_t length)
+{
+    data_buff_t *data_buf = ns_sal_rx_buffer_alloc(length);
+    if (!TEST_NEQ(data_buf, NULL)) {
+        return;
+    }
+    memset(&data_buf->ns_address, 0, sizeof(data_buf->ns_address));
+    data_buf->length = length;
+    data_buf->offset = 0;
+    memset(data_buf->payload, value, length);
+    ns_sal_callback_data_received(sock, data_buf);
+}
+
+int ns_socket_test_rcvbuf_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    uint32_t limit;
+    uint32_t dropped;
+    uint8_t policy;
+    uint8_t buf[20];
+    size_t len;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &rcvbuf_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // defaults
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(limit, 0);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF_POLICY, &policy, sizeof(policy));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(policy, NS_SAL_RCVBUF_DROP_NEWEST);
+
+    // error values
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF, NULL, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF, &limit, 1);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+    policy = NS_SAL_RCVBUF_REJECT + 1;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF_POLICY, &policy, sizeof(policy));
+    TEST_EQ(err, SOCKET_ERROR_BAD_ARGUMENT);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_DROPPED, &dropped, sizeof(dropped));
+    TEST_EQ(err, SOCKET_ERROR_UNIMPLEMENTED);
+
+    // limit queue to two 10 byte datagrams
+    limit = 20;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // drop newest: third datagram is dropped silently
+    rcvbuf_rx_done_count = rcvbuf_rx_error_count = 0;
+    rcvbuf_inject_datagram(&sock, 1, 10);
+    rcvbuf_inject_datagram(&sock, 2, 10);
+    rcvbuf_inject_datagram(&sock, 3, 10);
+    TEST_EQ(rcvbuf_rx_done_count, 2);
+    TEST_EQ(rcvbuf_rx_error_count, 0);
+    len = sizeof(buf);
+    err = api->recv(&sock, buf, &len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(buf[0], 1);
+
+    // drop oldest: datagram 2 is dropped to make space for 4 and 5
+    policy = NS_SAL_RCVBUF_DROP_OLDEST;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF_POLICY, &policy, sizeof(policy));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    rcvbuf_inject_datagram(&sock, 4, 10);
+    rcvbuf_inject_datagram(&sock, 5, 10);
+    len = sizeof(buf);
+    err = api->recv(&sock, buf, &len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(buf[0], 4);
+
+    // reject: datagram 7 is dropped and error event is sent
+    policy = NS_SAL_RCVBUF_REJECT;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF_POLICY, &policy, sizeof(policy));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    rcvbuf_rx_error_count = 0;
+    rcvbuf_inject_datagram(&sock, 6, 10);
+    rcvbuf_inject_datagram(&sock, 7, 10);
+    TEST_EQ(rcvbuf_rx_error_count, 1);
+    TEST_EQ(rcvbuf_rx_error, SOCKET_ERROR_SIZE);
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_DROPPED, &dropped, sizeof(dropped));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(dropped, 3);
+
+    // destroy the socket, queued datagrams are released
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // test with destroyed socket
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RCVBUF, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+
+    TEST_RETURN();
+}
+
+int ns_socket_test_rcvbuf_stream_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_STREAM;
+    sock_data_s *sock_data_ptr;
+    uint32_t limit;
+    uint32_t dropped;
+    uint8_t policy;
+    uint8_t buf[40];
+    size_t len;
+    uint8_t i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &rcvbuf_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+    sock_data_ptr = (sock_data_s *) sock.impl;
+
+    limit = 20;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RCVBUF, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    policy = NS_SAL_RCVBUF_DROP_OLDEST;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RCVBUF_POLICY, &policy, sizeof(policy));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // segments within the limit are read to the receive queue
+    rcvbuf_rx_done_count = rcvbuf_rx_error_count = 0;
+    TEST_EQ(ns_sal_callback_rx_leave(&sock, 10), 0);
+    rcvbuf_inject_datagram(&sock, 1, 10);
+    TEST_EQ(ns_sal_callback_rx_leave(&sock, 10), 0);
+    rcvbuf_inject_datagram(&sock, 2, 10);
+
+    // segment over the limit is left to NanoStack, not dropped
+    TEST_EQ(ns_sal_callback_rx_leave(&sock, 10), 1);
+    sock_data_ptr->rx_pending = 1;
+    // later segments stay behind it, even if they would fit
+    TEST_EQ(ns_sal_callback_rx_leave(&sock, 1), 1);
+    sock_data_ptr->rx_pending = 0;
+
+    // segments queued over the limit are never dropped, whatever the policy
+    for (policy = NS_SAL_RCVBUF_DROP_NEWEST; policy <= NS_SAL_RCVBUF_REJECT; policy++) {
+        err = api->set_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RCVBUF_POLICY, &policy, sizeof(policy));
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        rcvbuf_inject_datagram(&sock, 3 + policy, 5);
+    }
+    TEST_EQ(rcvbuf_rx_error_count, 0);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_DROPPED, &dropped, sizeof(dropped));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(dropped, 0);
+
+    // all data is read in order
+    len = sizeof(buf);
+    err = api->recv(&sock, buf, &len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, 35);
+    for (i = 0; i < len; i++) {
+        uint8_t expect = (i < 10) ? 1 : (i < 20) ? 2 : 3 + (i - 20) / 5;
+        if (!TEST_EQ(buf[i], expect)) {
+            break;
+        }
+    }
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_RETURN();
+}
+
+int ns_socket_test_recv_borrow_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    client_socket = &sock;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    const uint8_t *data = NULL;
+    struct socket_addr addr;
+    uint16_t port;
+    uint8_t buf[20];
+    size_t len;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &rcvbuf_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // error values
+    err = api_ext->recv_borrow(&sock, NULL, &len, NULL, NULL);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+    err = api_ext->recv_borrow(&sock, &data, &len, NULL, NULL);
+    TEST_EQ(err, SOCKET_ERROR_WOULD_BLOCK);
+    err = api_ext->recv_release(&sock);
+    TEST_EQ(err, SOCKET_ERROR_BAD_ARGUMENT);
+
+    rcvbuf_inject_datagram(&sock, 1, 10);
+    rcvbuf_inject_datagram(&sock, 2, 5);
+
+    // borrow first datagram, other receive functions are blocked
+    err = api_ext->recv_borrow(&sock, &data, &len, &addr, &port);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, 10);
+    if (TEST_NEQ(data, NULL)) {
+        TEST_EQ(data[0], 1);
+    }
+    err = api_ext->recv_borrow(&sock, &data, &len, NULL, NULL);
+    TEST_EQ(err, SOCKET_ERROR_BUSY);
+    len = sizeof(buf);
+    err = api->recv(&sock, buf, &len);
+    TEST_EQ(err, SOCKET_ERROR_BUSY);
+
+    err = api_ext->recv_release(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // second datagram is available with normal receive
+    len = sizeof(buf);
+    err = api->recv(&sock, buf, &len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, 5);
+    TEST_EQ(buf[0], 2);
+
+    // borrowed data is released when socket is destroyed
+    rcvbuf_inject_datagram(&sock, 3, 10);
+    err = api_ext->recv_borrow(&sock, &data, &len, NULL, NULL);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // test with destroyed socket
+    err = api_ext->recv_release(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+
+    TEST_RETURN();
+}
+
+/*
+ * Append stream data to the last receive buffer as the NanoStack wrapper does
+ * in NS_SAL_OPT_RX_COALESCE mode.
+ * \return 1 if data was appended, 0 if it would be stored to a new buffer
+ */
+static int rx_coalesce_append(struct socket *sock, uint8_t value, uint16_t length)
+{
+    uint8_t *space = ns_sal_callback_rx_append_space(sock, length);
+    if (NULL == space) {
+        return 0;
+    }
+    memset(space, value, length);
+    ns_sal_callback_rx_appended(sock, length);
+    return 1;
+}
+
+int ns_socket_test_rx_coalesce_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    client_socket = &sock;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_STREAM;
+    struct ns_sal_rx_queued queued;
+    const uint8_t *data = NULL;
+    uint8_t coalesce;
+    uint32_t limit;
+    uint32_t dropped;
+    uint8_t buf[20];
+    size_t len;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &rcvbuf_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // coalescing is disabled by default
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_COALESCE, &coalesce, sizeof(coalesce));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(coalesce, 0);
+    rcvbuf_rx_done_count = 0;
+    rcvbuf_inject_datagram(&sock, 1, 10);
+    TEST_EQ(rx_coalesce_append(&sock, 2, 20), 0);
+
+    coalesce = 1;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_COALESCE, &coalesce, sizeof(coalesce));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // segment is appended to the tail buffer
+    TEST_EQ(rx_coalesce_append(&sock, 2, 20), 1);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_QUEUED, &queued, sizeof(queued));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(queued.count, 1);
+    TEST_EQ(queued.bytes, 30);
+
+    // appended data counts to the receive queue limit
+    limit = 40;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RCVBUF, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(rx_coalesce_append(&sock, 3, 20), 0);
+    // wrapper then stores the segment to a new buffer, which the limit drops
+    rcvbuf_inject_datagram(&sock, 3, 20);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_DROPPED, &dropped, sizeof(dropped));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(dropped, 1);
+    // segment that fits exactly to the limit is appended
+    TEST_EQ(rx_coalesce_append(&sock, 4, 10), 1);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_QUEUED, &queued, sizeof(queued));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(queued.count, 1);
+    TEST_EQ(queued.bytes, 40);
+
+    limit = 0;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RCVBUF, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // borrow the buffer and append to it while borrowed
+    err = api_ext->recv_borrow(&sock, &data, &len, NULL, NULL);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, 40);
+    if (TEST_NEQ(data, NULL)) {
+        TEST_EQ(data[0], 1);
+        TEST_EQ(data[10], 2);
+        TEST_EQ(data[39], 4);
+    }
+    TEST_EQ(rx_coalesce_append(&sock, 5, 5), 1);
+
+    // release keeps the data appended after borrowing
+    err = api_ext->recv_release(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_QUEUED, &queued, sizeof(queued));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(queued.count, 1);
+    TEST_EQ(queued.bytes, 5);
+    len = sizeof(buf);
+    err = api->recv(&sock, buf, &len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, 5);
+    TEST_EQ(buf[0], 5);
+    TEST_EQ(buf[4], 5);
+
+    // RX_DONE is sent for every appended segment
+    TEST_EQ(rcvbuf_rx_done_count, 4);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    TEST_RETURN();
+}
+
+int ns_socket_test_rx_peek_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_rx_queued queued;
+    struct ns_sal_rx_peek peek;
+    uint8_t buf[20];
+    size_t len;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &rcvbuf_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // empty queue
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_QUEUED, &queued, sizeof(queued));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(queued.bytes, 0);
+    TEST_EQ(queued.next_len, 0);
+    peek.buf = buf;
+    peek.len = sizeof(buf);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_PEEK, &peek, sizeof(peek));
+    TEST_EQ(err, SOCKET_ERROR_WOULD_BLOCK);
+
+    rcvbuf_inject_datagram(&sock, 1, 10);
+    rcvbuf_inject_datagram(&sock, 2, 5);
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_QUEUED, &queued, sizeof(queued));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(queued.bytes, 15);
+    TEST_EQ(queued.count, 2);
+    TEST_EQ(queued.next_len, 10);
+
+    // peek truncated datagram, data stays in queue
+    peek.buf = buf;
+    peek.len = 4;
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_PEEK, &peek, sizeof(peek));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(peek.len, 4);
+    TEST_EQ(buf[0], 1);
+
+    len = sizeof(buf);
+    err = api->recv(&sock, buf, &len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, 10);
+    TEST_EQ(buf[0], 1);
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_QUEUED, &queued, sizeof(queued));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(queued.bytes, 5);
+    TEST_EQ(queued.next_len, 5);
+
+    // destroy the socket
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    TEST_RETURN();
+}
+
+int ns_tcp_test_slow_reader(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                            uint16_t block_size, uint8_t block_count)
+{
+    struct socket s;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    struct socket_addr addr;
+    rx_pool_stats_t stats_start;
+    rx_pool_stats_t stats_end;
+    mbed::Timeout to;
+    uint8_t direct = 1;
+    size_t rx_total = 0;
+    size_t tx_total = block_size * block_count;
+    uint8_t i;
+
+    ConnectCloseSock = &s;
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s server: %s:%d\r\n", __func__, server, (int) port);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    uint8_t *txdata = (uint8_t *)malloc(tx_total);
+    uint8_t *rxdata = (uint8_t *)malloc(tx_total);
+    if (!TEST_NEQ(txdata, NULL) || !TEST_NEQ(rxdata, NULL)) {
+        free(txdata);
+        free(rxdata);
+        TEST_RETURN();
+    }
+    // first byte zero makes test server to echo all data
+    for (i = 0; i < block_count; i++) {
+        memset(&txdata[i * block_size], i, block_size);
+    }
+
+    // Zero the implementation
+    s.impl = NULL;
+    err = api->create(&s, SOCKET_AF_INET6, SOCKET_STREAM, &connect_close_handler);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+
+    // leave received data to NanoStack
+    err = api->set_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_RX_DIRECT, &direct, sizeof(direct));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // Tell the host launch a server
+    TEST_PRINT(">>> ES,%d\r\n", SOCKET_STREAM);
+
+    err = api->str2addr(&s, &addr, server);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    timedout = 0;
+    connected = 0;
+    to.attach(onTimeout, 4 * SOCKET_TEST_TIMEOUT);
+    err = api->connect(&s, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    while (!connected && !timedout) {
+        run_cb();
+    }
+    to.detach();
+    if (!TEST_EQ(timedout, 0)) {
+        goto test_destroy;
+    }
+
+    ns_sal_rx_pool_stats_get(&stats_start);
+
+    // send all blocks without reading the echoed data
+    for (i = 0; i < block_count; i++) {
+        connect_tx_done = false;
+        timedout = 0;
+        to.attach(onTimeout, 2 * SOCKET_TEST_TIMEOUT);
+        err = api->send(&s, &txdata[i * block_size], block_size);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            to.detach();
+            break;
+        }
+        while (!timedout && !connect_tx_done) {
+            run_cb();
+        }
+        to.detach();
+    }
+
+    // let echoed data arrive
+    timedout = 0;
+    to.attach(onTimeout, 2 * SOCKET_TEST_TIMEOUT);
+    while (!timedout) {
+        run_cb();
+    }
+    to.detach();
+
+    // SAL must not buffer unread data
+    ns_sal_rx_pool_stats_get(&stats_end);
+    TEST_EQ(stats_end.alloc_count, stats_start.alloc_count);
+    TEST_EQ(stats_end.fallback_count, stats_start.fallback_count);
+    TEST_EQ(((sock_data_s *) s.impl)->rx_queue.bytes, 0);
+
+    // read slowly in small pieces
+    timedout = 0;
+    to.attach(onTimeout, 4 * SOCKET_TEST_TIMEOUT);
+    while (!timedout && rx_total < tx_total) {
+        size_t len = tx_total - rx_total;
+        if (len > 32) {
+            len = 32;
+        }
+        err = api->recv(&s, &rxdata[rx_total], &len);
+        if (err == SOCKET_ERROR_NONE) {
+            rx_total += len;
+        } else if (err != SOCKET_ERROR_WOULD_BLOCK) {
+            break;
+        }
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(rx_total, tx_total);
+    TEST_EQ(memcmp(txdata, rxdata, rx_total), 0);
+
+    err = api->close(&s);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+test_destroy:
+    // Tell the host to kill the server
+    TEST_PRINT(">>> KILL ES\r\n");
+    err = api->destroy(&s);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+test_exit:
+    free(txdata);
+    free(rxdata);
+    TEST_RETURN();
+}
+
+int ns_socket_test_rx_overrun_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    uint32_t overrun;
+    uint32_t dropped;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &rcvbuf_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_OVERRUN, &overrun, sizeof(overrun));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(overrun, 0);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_OVERRUN, &overrun, 1);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_OVERRUN, &overrun, sizeof(overrun));
+    TEST_EQ(err, SOCKET_ERROR_UNIMPLEMENTED);
+
+    // overruns are reported as receive errors, not as send errors
+    rcvbuf_rx_done_count = rcvbuf_rx_error_count = 0;
+    ns_sal_callback_rx_overrun(&sock);
+    ns_sal_callback_rx_overrun(&sock);
+    TEST_EQ(rcvbuf_rx_error_count, 2);
+    TEST_EQ(rcvbuf_rx_error, SOCKET_ERROR_BAD_ALLOC);
+    TEST_EQ(rcvbuf_rx_done_count, 0);
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_OVERRUN, &overrun, sizeof(overrun));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(overrun, 2);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_DROPPED, &dropped, sizeof(dropped));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(dropped, 0);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    TEST_RETURN();
+}
+
+int ns_socket_test_sendv_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    client_socket = &sock;
+    struct socket_addr addr;
+    uint16_t port = 10000;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    char data[10];
+    struct ns_sal_iovec iov[2];
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &client_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+
+    iov[0].base = data;
+    iov[0].len = sizeof(data);
+    iov[1].base = NULL;
+    iov[1].len = sizeof(data);
+
+    // test vector NULL
+    err = api_ext->sendv_to(&sock, NULL, 2, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+
+    // test vector element NULL
+    err = api_ext->sendv_to(&sock, iov, 2, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+
+    // test vector is empty
+    err = api_ext->sendv_to(&sock, iov, 0, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+
+    // test data len is 0
+    iov[0].len = 0;
+    iov[1].len = 0;
+    err = api_ext->sendv_to(&sock, iov, 2, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+
+    // test data len does not fit to NanoStack
+    iov[0].len = 0x8000;
+    iov[1].base = data;
+    iov[1].len = 0x8000;
+    err = api_ext->sendv_to(&sock, iov, 2, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+
+    // test addr is NULL
+    iov[0].len = sizeof(data);
+    iov[1].len = sizeof(data);
+    err = api_ext->sendv_to(&sock, iov, 2, NULL, port);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+
+    // destroy the socket
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // test with destroyed socket
+    err = api_ext->sendv_to(&sock, iov, 2, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+    err = api_ext->sendv(&sock, iov, 2);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+
+    // Create a TCP socket
+    pf = SOCKET_STREAM;
+    err = api->create(&sock, af, pf, &client_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+    err = api_ext->sendv_to(&sock, iov, 2, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_BAD_FAMILY);
+    // destroy the socket
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+test_exit:
+    TEST_RETURN();
+}
+
+int ns_socket_test_sndspace_api(socket_stack_t stack)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_tx_space space;
+    uint32_t sndbuf;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &client_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDBUF, &sndbuf, sizeof(sndbuf));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_NEQ(sndbuf, 0);
+
+    // test NULL and wrong size
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDBUF, NULL, sizeof(sndbuf));
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDBUF, &sndbuf, 1);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDSPACE, &space, 1);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+
+    // space is get only
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDSPACE, &space, sizeof(space));
+    TEST_EQ(err, SOCKET_ERROR_UNIMPLEMENTED);
+
+    // nothing sent, whole buffer is free
+    sndbuf = 1000;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDBUF, &sndbuf, sizeof(sndbuf));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDSPACE, &space, sizeof(space));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(space.in_flight, 0);
+    TEST_EQ(space.queued, 0);
+    TEST_EQ(space.free, 1000);
+
+    // destroy the socket
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // test with destroyed socket
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDSPACE, &space, sizeof(space));
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+
+test_exit:
+    TEST_RETURN();
+}
+
+int ns_socket_test_handle_api(socket_stack_t stack)
+{
+    struct socket sock_a;
+    struct socket sock_b;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock_a;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    ns_wrapper_handle_t handle_a;
+    ns_wrapper_handle_t handle_b;
+    int i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d\r\n", __func__, (int) af, (int) pf);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock_a.impl = NULL;
+    sock_b.impl = NULL;
+    err = api->create(&sock_a, af, pf, &client_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+    handle_a = ((sock_data_s *) sock_a.impl)->handle;
+    TEST_EQ(ns_wrapper_socket_context_lookup(handle_a), &sock_a);
+
+    // handle is invalid after socket is destroyed
+    err = api->destroy(&sock_a);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(ns_wrapper_socket_context_lookup(handle_a), NULL);
+
+    // NanoStack reuses the socket ID, old handle must not find new socket
+    err = api->create(&sock_b, af, pf, &client_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+    handle_b = ((sock_data_s *) sock_b.impl)->handle;
+    TEST_NEQ(handle_a, handle_b);
+    TEST_EQ(ns_wrapper_socket_context_lookup(handle_a), NULL);
+    TEST_EQ(ns_wrapper_socket_context_lookup(handle_b), &sock_b);
+
+    err = api->destroy(&sock_b);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(ns_wrapper_socket_context_lookup(handle_b), NULL);
+
+    // old handle stays invalid over many reopens of the same socket ID
+    for (i = 0; i < 300; i++) {
+        err = api->create(&sock_b, af, pf, &client_cb);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            TEST_EXIT();
+        }
+        if (!TEST_EQ(ns_wrapper_socket_context_lookup(handle_a), NULL)) {
+            TEST_PRINT("stale handle matched after %d reopens\r\n", i);
+            api->destroy(&sock_b);
+            TEST_EXIT();
+        }
+        err = api->destroy(&sock_b);
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+    }
+
+test_exit:
+    TEST_RETURN();
+}
+
+int ns_udp_test_sendv_echo(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    client_socket = &sock;
+    mbed::Timeout to;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    const char body[] = " sendv body";
+    const char trailer[] = " trailer";
+    struct ns_sal_iovec iov[3];
+    char expect[SOCKET_SENDBUF_BLOCKSIZE + 1];
+    char rxdata[SOCKET_SENDBUF_BLOCKSIZE + 1];
+    size_t data_len;
+    size_t rxlen;
+    uint16_t rxport;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d\r\n", __func__, (int) af, (int) pf, server, (int) port);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    struct socket_addr addr;
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+    // Tell the host launch a server
+    TEST_PRINT(">>> ES,%d\r\n", pf);
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &client_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+
+    // header, body and trailer are sent as one datagram
+    iov[0].base = CMD_REPLY_ECHO;
+    iov[0].len = CMD_REPLY_ECHO_LEN;
+    iov[1].base = body;
+    iov[1].len = sizeof(body) - 1;
+    iov[2].base = trailer;
+    iov[2].len = sizeof(trailer) - 1;
+    data_len = snprintf(expect, sizeof(expect), "%s%s%s", CMD_REPLY_ECHO, body, trailer);
+
+    client_tx_done = false;
+    client_rx_done = false;
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_TIMEOUT);
+    err = api_ext->sendv_to(&sock, iov, 3, &addr, port);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_PRINT("Failed to send %u bytes\r\n", (unsigned) data_len);
+    } else {
+        while (!timedout && !client_tx_done) {
+            run_cb();
+        }
+        if (TEST_EQ(timedout, 0)) {
+            TEST_EQ(client_tx_info.sentbytes, data_len);
+        }
+    }
+    to.detach();
+
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_SERVER_TIMEOUT);
+    while (!timedout && !client_rx_done) {
+        run_cb();
+    }
+    to.detach();
+    if (TEST_EQ(timedout, 0)) {
+        rxlen = sizeof(rxdata);
+        err = api->recv_from(&sock, rxdata, &rxlen, &addr, &rxport);
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        TEST_EQ(rxlen, data_len);
+        TEST_EQ(rxport, port);
+        int res = memcmp(expect, rxdata, data_len);
+        if (!TEST_EQ(res, 0)) {
+            TEST_PRINT("Recv: %.*s\r\nSend: %s\r\n", (int) rxlen, rxdata, expect);
+        }
+    }
+
+    // destroy the socket
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+test_exit:
+    TEST_PRINT(">>> KILL,ES\r\n");
+    TEST_RETURN();
+}
+
+static volatile int tx_queue_tx_done_count;
+static volatile int tx_queue_tx_error_count;
+static volatile int rx_direct_rx_done_count;
+static volatile bool rx_direct_tx_done;
+static void rx_direct_socket_cb()
+{
+    switch (client_socket->event->event) {
+        case SOCKET_EVENT_RX_DONE:
+            rx_direct_rx_done_count++;
+            break;
+        case SOCKET_EVENT_TX_DONE:
+        case SOCKET_EVENT_TX_ERROR:
+            rx_direct_tx_done = true;
+            break;
+        default:
+            break;
+    }
+}
+
+int ns_udp_test_rx_direct(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    client_socket = &sock;
+    mbed::Timeout to;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_rx_queued queued;
+    struct ns_sal_datagram dgrams[2];
+    struct socket_addr addr;
+    struct socket_addr rxaddr;
+    char txdata[4][SOCKET_SENDBUF_BLOCKSIZE];
+    char rxdata[3][SOCKET_SENDBUF_BLOCKSIZE];
+    size_t tx_len[4];
+    size_t count;
+    size_t len;
+    uint16_t rxport;
+    uint8_t direct = 1;
+    int i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d\r\n", __func__, (int) af, (int) pf, server, (int) port);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+    // Tell the host launch a server
+    TEST_PRINT(">>> ES,%d\r\n", pf);
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &rx_direct_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+
+    // leave received datagrams to NanoStack
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_DIRECT, &direct, sizeof(direct));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    rx_direct_rx_done_count = 0;
+    for (i = 0; i < 4; i++) {
+        tx_len[i] = snprintf(txdata[i], sizeof(txdata[i]), "%s rx direct datagram %d", CMD_REPLY_ECHO, i);
+        rx_direct_tx_done = false;
+        timedout = 0;
+        to.attach(onTimeout, SOCKET_TEST_TIMEOUT);
+        err = api->send_to(&sock, txdata[i], tx_len[i], &addr, port);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            to.detach();
+            break;
+        }
+        while (!timedout && !rx_direct_tx_done) {
+            run_cb();
+        }
+        to.detach();
+    }
+
+    // wait for all echoes before reading any
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_SERVER_TIMEOUT);
+    while (!timedout && rx_direct_rx_done_count < 4) {
+        run_cb();
+    }
+    to.detach();
+    if (!TEST_EQ(rx_direct_rx_done_count, 4)) {
+        goto test_destroy;
+    }
+
+    // SAL has not buffered the datagrams
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_QUEUED, &queued, sizeof(queued));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(queued.count, 0);
+    TEST_EQ(queued.bytes, 0);
+
+    // recv reads first datagram from NanoStack
+    len = sizeof(rxdata[0]);
+    err = api->recv(&sock, rxdata[0], &len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, tx_len[0]);
+    TEST_EQ(memcmp(rxdata[0], txdata[0], tx_len[0]), 0);
+
+    // recv_from reads second datagram with sender address
+    len = sizeof(rxdata[0]);
+    err = api->recv_from(&sock, rxdata[0], &len, &rxaddr, &rxport);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(len, tx_len[1]);
+    TEST_EQ(rxport, port);
+    TEST_EQ(memcmp(rxdata[0], txdata[1], tx_len[1]), 0);
+
+    // recv_from_batch reads the rest, last datagram does not fit and is truncated
+    dgrams[0].buf = rxdata[1];
+    dgrams[0].len = sizeof(rxdata[1]);
+    dgrams[1].buf = rxdata[2];
+    dgrams[1].len = CMD_REPLY_ECHO_LEN;
+    count = 2;
+    err = api_ext->recv_from_batch(&sock, dgrams, &count);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(count, 2);
+    TEST_EQ(dgrams[0].len, tx_len[2]);
+    TEST_EQ(dgrams[0].port, port);
+    TEST_EQ(memcmp(rxdata[1], txdata[2], tx_len[2]), 0);
+    TEST_EQ(dgrams[1].len, CMD_REPLY_ECHO_LEN);
+    TEST_EQ(memcmp(rxdata[2], txdata[3], CMD_REPLY_ECHO_LEN), 0);
+
+    // rest of the truncated datagram is discarded like in buffered mode
+    len = sizeof(rxdata[0]);
+    err = api->recv(&sock, rxdata[0], &len);
+    TEST_EQ(err, SOCKET_ERROR_WOULD_BLOCK);
+
+test_destroy:
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+test_exit:
+    TEST_PRINT(">>> KILL,ES\r\n");
+    TEST_RETURN();
+}
+
+static void tx_queue_socket_cb()
+{
+    switch (client_socket->event->event) {
+        case SOCKET_EVENT_TX_DONE:
+            tx_queue_tx_done_count++;
+            break;
+        case SOCKET_EVENT_TX_ERROR:
+            tx_queue_tx_error_count++;
+            break;
+        default:
+            break;
+    }
+}
+
+int ns_udp_test_tx_queue(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                         uint16_t burst)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    mbed::Timeout to;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_tx_queue_stats stats;
+    struct ns_sal_tx_space space;
+    uint32_t limit;
+    char data[SOCKET_SENDBUF_BLOCKSIZE];
+    int i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d, burst: %d\r\n", __func__, (int) af, (int) pf, server, (int) port, (int) burst);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    struct socket_addr addr;
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &tx_queue_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // queue is disabled by default
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(limit, 0);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, 1);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TX_QUEUE_STATS, &stats, sizeof(stats));
+    TEST_EQ(err, SOCKET_ERROR_UNIMPLEMENTED);
+
+    // room for whole burst
+    limit = burst * sizeof(data);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // back-to-back sends, NanoStack is busy after the first one
+    tx_queue_tx_done_count = tx_queue_tx_error_count = 0;
+    for (i = 0; i < burst; i++) {
+        snprintf(data, sizeof(data), "%s tx queue %03d", CMD_REPLY_ECHO, i);
+        err = api->send_to(&sock, data, sizeof(data), &addr, port);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            TEST_PRINT("send_to() failed at %d\r\n", i);
+            break;
+        }
+    }
+
+    // whole burst is either in NanoStack or in SAL queue
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDSPACE, &space, sizeof(space));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(space.in_flight + space.queued, burst * sizeof(data));
+
+    timedout = 0;
+    to.attach(onTimeout, burst * SOCKET_TEST_TIMEOUT);
+    while (!timedout && tx_queue_tx_done_count + tx_queue_tx_error_count < burst) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(timedout, 0);
+    TEST_EQ(tx_queue_tx_done_count, burst);
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TX_QUEUE_STATS, &stats, sizeof(stats));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(stats.count, 0);
+    TEST_EQ(stats.bytes, 0);
+    TEST_PRINT("tx queue: %lu queued, max depth %d, max latency %lu us, last latency %lu us\r\n",
+               (unsigned long) stats.queued, stats.max_count,
+               (unsigned long) stats.latency_max_us, (unsigned long) stats.latency_last_us);
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDSPACE, &space, sizeof(space));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(space.in_flight, 0);
+    TEST_EQ(space.queued, 0);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    TEST_RETURN();
+}
+
+int ns_udp_test_send_batch_order(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    client_socket = &sock;
+    mbed::Timeout to;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_tx_queue_stats stats;
+    struct ns_sal_datagram dgrams[4];
+    socket_error_t status[4];
+    struct socket_addr addr;
+    uint32_t limit;
+    uint8_t data[32];
+    int i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d\r\n", __func__, (int) af, (int) pf, server, (int) port);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &tx_queue_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // queue has space for the small datagram only
+    limit = 20;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    memset(data, 'b', sizeof(data));
+    for (i = 0; i < 4; i++) {
+        dgrams[i].buf = data;
+        dgrams[i].addr = addr;
+        dgrams[i].port = port;
+    }
+    dgrams[0].len = 16;             // sent to NanoStack
+    dgrams[1].buf = NULL;           // rejected
+    dgrams[1].len = 16;
+    dgrams[2].len = sizeof(data);   // NanoStack busy and does not fit to queue
+    dgrams[3].len = 8;              // would fit to queue, but must not overtake
+
+    tx_queue_tx_done_count = 0;
+    tx_queue_tx_error_count = 0;
+    err = api_ext->send_to_batch(&sock, dgrams, status, 4);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+    TEST_EQ(status[0], SOCKET_ERROR_NONE);
+    TEST_EQ(status[1], SOCKET_ERROR_NULL_PTR);
+    TEST_EQ(status[2], SOCKET_ERROR_BUSY);
+    TEST_EQ(status[3], SOCKET_ERROR_BUSY);
+
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TX_QUEUE_STATS, &stats, sizeof(stats));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(stats.count, 0);
+    TEST_EQ(stats.queued, 0);
+
+    // let first datagram complete before destroying the socket
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_TIMEOUT);
+    while (!timedout && 0 == tx_queue_tx_done_count + tx_queue_tx_error_count) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(timedout, 0);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_RETURN();
+}
+
+static void priority_high_socket_cb()
+{
+    // events of the high priority socket are not checked
+}
+
+int ns_udp_test_priority_close(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb)
+{
+    struct socket high;
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    mbed::Timeout to;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_tx_queue_stats stats;
+    struct socket_addr addr;
+    uint32_t limit;
+    uint8_t priority;
+    uint8_t data[SOCKET_SENDBUF_BLOCKSIZE];
+    int round;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d\r\n", __func__, (int) af, (int) pf, server, (int) port);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    err = api->create(&sock, af, pf, &tx_queue_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+    limit = 4 * sizeof(data);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    memset(data, 'p', sizeof(data));
+
+    // round 0 closes, round 1 destroys the high priority socket while its send is in flight
+    for (round = 0; round < 2; round++) {
+        high.impl = NULL;
+        err = api->create(&high, af, pf, &priority_high_socket_cb);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            break;
+        }
+        priority = NS_SAL_PRIORITY_MAX;
+        err = api->set_option(&high, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PRIORITY, &priority, sizeof(priority));
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+
+        tx_queue_tx_done_count = 0;
+        tx_queue_tx_error_count = 0;
+        err = api->send_to(&high, data, sizeof(data), &addr, port);
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        // held behind the high priority datagram
+        err = api->send_to(&sock, data, sizeof(data), &addr, port);
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TX_QUEUE_STATS, &stats, sizeof(stats));
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        TEST_EQ(stats.count, 1);
+
+        if (0 == round) {
+            err = api->close(&high);
+            TEST_EQ(err, SOCKET_ERROR_NONE);
+        } else {
+            err = api->destroy(&high);
+            TEST_EQ(err, SOCKET_ERROR_NONE);
+        }
+        // released without waiting for TX_DONE of the high priority socket
+        err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TX_QUEUE_STATS, &stats, sizeof(stats));
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        TEST_EQ(stats.count, 0);
+
+        timedout = 0;
+        to.attach(onTimeout, SOCKET_TEST_TIMEOUT);
+        while (!timedout && 0 == tx_queue_tx_done_count + tx_queue_tx_error_count) {
+            run_cb();
+        }
+        to.detach();
+        TEST_EQ(timedout, 0);
+        TEST_EQ(tx_queue_tx_done_count, 1);
+
+        if (0 == round) {
+            err = api->destroy(&high);
+            TEST_EQ(err, SOCKET_ERROR_NONE);
+        }
+    }
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_RETURN();
+}
+
+int ns_udp_test_pacing(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                       uint32_t rate, uint32_t burst, uint8_t count)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    mbed::Timeout to;
+    mbed::Timer timer;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_pacing pacing;
+    struct ns_sal_tx_queue_stats stats;
+    char data[SOCKET_SENDBUF_BLOCKSIZE];
+    uint32_t expect_ms;
+    int elapsed_ms;
+    uint8_t i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d, rate: %lu, burst: %lu, count: %d\r\n", __func__, (int) af, (int) pf,
+               server, (int) port, (unsigned long) rate, (unsigned long) burst, (int) count);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    struct socket_addr addr;
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &tx_queue_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // pacing is disabled by default
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PACING, &pacing, sizeof(pacing));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(pacing.rate, 0);
+    TEST_EQ(api->periodic_task(&sock), NULL);
+    TEST_EQ(api->periodic_interval(&sock), 0);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PACING, &pacing, 1);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+    pacing.rate = rate;
+    pacing.burst = 0;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PACING, &pacing, sizeof(pacing));
+    TEST_EQ(err, SOCKET_ERROR_BAD_ARGUMENT);
+
+    pacing.burst = burst;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PACING, &pacing, sizeof(pacing));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    // paced datagrams are released from SAL transmit timer, not from socket periodic task
+    TEST_EQ(api->periodic_task(&sock), NULL);
+
+    // burst is sent at once, rest is released at pacing rate
+    tx_queue_tx_done_count = tx_queue_tx_error_count = 0;
+    timer.start();
+    for (i = 0; i < count; i++) {
+        snprintf(data, sizeof(data), "%s paced %03d", CMD_REPLY_ECHO, i);
+        err = api->send_to(&sock, data, sizeof(data), &addr, port);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            TEST_PRINT("send_to() failed at %d\r\n", i);
+            count = i;
+            break;
+        }
+    }
+
+    timedout = 0;
+    to.attach(onTimeout, count * SOCKET_TEST_TIMEOUT);
+    while (!timedout && tx_queue_tx_done_count + tx_queue_tx_error_count < count) {
+        run_cb();
+    }
+    to.detach();
+    timer.stop();
+    TEST_EQ(timedout, 0);
+    TEST_EQ(tx_queue_tx_done_count, count);
+
+    elapsed_ms = timer.read_ms();
+    expect_ms = (count * sizeof(data) > burst) ? (count * sizeof(data) - burst) * 1000 / rate : 0;
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TX_QUEUE_STATS, &stats, sizeof(stats));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_PRINT("paced %d datagrams in %d ms, expected at least %lu ms, max queue latency %lu us\r\n",
+               (int) count, elapsed_ms, (unsigned long) expect_ms, (unsigned long) stats.latency_max_us);
+    // allow one timer tick of jitter
+    TEST_EQ(elapsed_ms + 20 >= (int) expect_ms, true);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    TEST_RETURN();
+}
+
+int ns_udp_test_pacing_timer(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    client_socket = &sock;
+    mbed::Timeout to;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    struct ns_sal_pacing pacing;
+    struct ns_sal_tx_queue_stats stats;
+    struct socket_addr addr;
+    char data[SOCKET_SENDBUF_BLOCKSIZE];
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d\r\n", __func__, (int) af, (int) pf, server, (int) port);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    err = api->create(&sock, af, pf, &tx_queue_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // pacing enabled after open, bucket refills one datagram in two seconds
+    pacing.rate = sizeof(data) / 2;
+    pacing.burst = sizeof(data);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PACING, &pacing, sizeof(pacing));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    memset(data, 't', sizeof(data));
+    tx_queue_tx_done_count = tx_queue_tx_error_count = 0;
+    err = api->send_to(&sock, data, sizeof(data), &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    err = api->send_to(&sock, data, sizeof(data), &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // first datagram completes while the bucket is empty
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_TIMEOUT);
+    while (!timedout && 0 == tx_queue_tx_done_count + tx_queue_tx_error_count) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(tx_queue_tx_done_count, 1);
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TX_QUEUE_STATS, &stats, sizeof(stats));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(stats.count, 1);
+
+    // no further TX_DONE comes, the held datagram is released by the timer
+    timedout = 0;
+    to.attach(onTimeout, 4 * SOCKET_TEST_TIMEOUT);
+    while (!timedout && tx_queue_tx_done_count + tx_queue_tx_error_count < 2) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(timedout, 0);
+    TEST_EQ(tx_queue_tx_done_count, 2);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_RETURN();
+}
+
+int ns_udp_test_send_buffer(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                            uint8_t count)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    client_socket = &sock;
+    mbed::Timeout to;
+    socket_address_family_t af = SOCKET_AF_INET6;
+    socket_proto_family_t pf = SOCKET_DGRAM;
+    ns_sal_tx_handle_t handles[8];
+    ns_sal_tx_handle_t handle;
+    socket_error_t status;
+    uint8_t *data;
+    uint32_t limit;
+    uint8_t i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s af: %d, pf: %d, server: %s:%d, count: %d\r\n", __func__, (int) af, (int) pf, server, (int) port, (int) count);
+
+    if (count > sizeof(handles) / sizeof(handles[0])) {
+        count = sizeof(handles) / sizeof(handles[0]);
+    }
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    struct socket_addr addr;
+    // Resolve the host address
+    err = blocking_resolve(stack, af, server, &addr);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // Zero the socket implementation
+    sock.impl = NULL;
+    // Create a socket
+    err = api->create(&sock, af, pf, &tx_queue_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // argument checks
+    handle = api_ext->tx_alloc(0, &data);
+    TEST_EQ(handle, NULL);
+    handle = api_ext->tx_alloc(SOCKET_SENDBUF_BLOCKSIZE, NULL);
+    TEST_EQ(handle, NULL);
+    handle = api_ext->tx_alloc(SOCKET_SENDBUF_BLOCKSIZE, &data);
+    if (!TEST_NEQ(handle, NULL)) {
+        TEST_EXIT();
+    }
+    err = api_ext->send_buffer(&sock, NULL, SOCKET_SENDBUF_BLOCKSIZE, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NULL_PTR);
+    err = api_ext->send_buffer(&sock, handle, 0, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+    err = api_ext->send_buffer(&sock, handle, SOCKET_SENDBUF_BLOCKSIZE + 1, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+    err = api_ext->tx_reclaim(&sock, &handles[0], &status);
+    TEST_EQ(err, SOCKET_ERROR_WOULD_BLOCK);
+    api_ext->tx_free(handle);
+
+    // without transmit queue, busy NanoStack returns the buffer to application
+    handles[0] = api_ext->tx_alloc(SOCKET_SENDBUF_BLOCKSIZE, &data);
+    handles[1] = api_ext->tx_alloc(SOCKET_SENDBUF_BLOCKSIZE, &data);
+    if (!TEST_NEQ(handles[0], NULL) || !TEST_NEQ(handles[1], NULL)) {
+        api_ext->tx_free(handles[0]);
+        api_ext->tx_free(handles[1]);
+        TEST_EXIT();
+    }
+    tx_queue_tx_done_count = tx_queue_tx_error_count = 0;
+    err = api_ext->send_buffer(&sock, handles[0], SOCKET_SENDBUF_BLOCKSIZE, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    err = api_ext->send_buffer(&sock, handles[1], SOCKET_SENDBUF_BLOCKSIZE, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_BUSY);
+    api_ext->tx_free(handles[1]);
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_TIMEOUT);
+    while (!timedout && 0 == tx_queue_tx_done_count + tx_queue_tx_error_count) {
+        run_cb();
+    }
+    to.detach();
+    err = api_ext->tx_reclaim(&sock, &handle, &status);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(handle, handles[0]);
+    api_ext->tx_free(handle);
+
+    // queued buffers are limited by the transmit queue
+    limit = (count - 1) * SOCKET_SENDBUF_BLOCKSIZE;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // data is written directly to socket buffers and sent back-to-back,
+    // buffers are queued without copying while NanoStack is busy
+    tx_queue_tx_done_count = tx_queue_tx_error_count = 0;
+    for (i = 0; i < count; i++) {
+        handles[i] = api_ext->tx_alloc(SOCKET_SENDBUF_BLOCKSIZE, &data);
+        if (!TEST_NEQ(handles[i], NULL)) {
+            count = i;
+            break;
+        }
+        snprintf((char *) data, SOCKET_SENDBUF_BLOCKSIZE, "%s send buffer %03d", CMD_REPLY_ECHO, i);
+        err = api_ext->send_buffer(&sock, handles[i], SOCKET_SENDBUF_BLOCKSIZE, &addr, port);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            api_ext->tx_free(handles[i]);
+            count = i;
+            break;
+        }
+    }
+
+    timedout = 0;
+    to.attach(onTimeout, count * SOCKET_TEST_TIMEOUT);
+    while (!timedout && tx_queue_tx_done_count + tx_queue_tx_error_count < count) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(timedout, 0);
+    TEST_EQ(tx_queue_tx_done_count, count);
+
+    // buffers come back in send order
+    for (i = 0; i < count; i++) {
+        err = api_ext->tx_reclaim(&sock, &handle, &status);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            break;
+        }
+        TEST_EQ(handle, handles[i]);
+        TEST_EQ(status, SOCKET_ERROR_NONE);
+        api_ext->tx_free(handle);
+    }
+    err = api_ext->tx_reclaim(&sock, &handle, &status);
+    TEST_EQ(err, SOCKET_ERROR_WOULD_BLOCK);
+
+test_exit:
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    TEST_RETURN();
+}
+
+int ns_tcp_test_cork(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                     uint16_t write_len, uint8_t write_count)
+{
+    struct socket s;
+    struct socket dgram;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    const struct ns_sal_socket_api_ext *api_ext = &nanostack_socket_api_ext;
+    struct ns_sal_iovec iov[2];
+    struct socket_addr addr;
+    mbed::Timeout to;
+    uint8_t cork = 1;
+    uint8_t nodelay = 0;
+    size_t rx_total = 0;
+    size_t tx_total = write_len * write_count;
+    uint8_t i;
+
+    ConnectCloseSock = &s;
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s server: %s:%d, %d writes of %d bytes\r\n", __func__, server, (int) port,
+               (int) write_count, (int) write_len);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+    err = api->init();
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    // coalescing options are for stream sockets only
+    dgram.impl = NULL;
+    err = api->create(&dgram, SOCKET_AF_INET6, SOCKET_DGRAM, &connect_close_handler);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+    err = api->set_option(&dgram, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_CORK, &cork, sizeof(cork));
+    TEST_EQ(err, SOCKET_ERROR_BAD_FAMILY);
+    err = api->set_option(&dgram, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_NODELAY, &nodelay, sizeof(nodelay));
+    TEST_EQ(err, SOCKET_ERROR_BAD_FAMILY);
+    err = api->destroy(&dgram);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    uint8_t *txdata = (uint8_t *)malloc(tx_total);
+    uint8_t *rxdata = (uint8_t *)malloc(tx_total);
+    if (!TEST_NEQ(txdata, NULL) || !TEST_NEQ(rxdata, NULL)) {
+        free(txdata);
+        free(rxdata);
+        TEST_RETURN();
+    }
+    // first byte zero makes test server to echo all data
+    for (i = 0; i < write_count; i++) {
+        memset(&txdata[i * write_len], i, write_len);
+    }
+
+    // Zero the implementation
+    s.impl = NULL;
+    err = api->create(&s, SOCKET_AF_INET6, SOCKET_STREAM, &connect_close_handler);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+
+    // defaults: no cork, no delay
+    err = api->get_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_CORK, &cork, sizeof(cork));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(cork, 0);
+    err = api->get_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_NODELAY, &nodelay, sizeof(nodelay));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(nodelay, 1);
+
+    // Tell the host launch a server
+    TEST_PRINT(">>> ES,%d\r\n", SOCKET_STREAM);
+
+    err = api->str2addr(&s, &addr, server);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    timedout = 0;
+    connected = 0;
+    to.attach(onTimeout, 4 * SOCKET_TEST_TIMEOUT);
+    err = api->connect(&s, &addr, port);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    while (!connected && !timedout) {
+        run_cb();
+    }
+    to.detach();
+    if (!TEST_EQ(timedout, 0)) {
+        goto test_destroy;
+    }
+
+    // corked writes are held in SAL
+    cork = 1;
+    err = api->set_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_CORK, &cork, sizeof(cork));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    connect_tx_done = false;
+    for (i = 0; i < write_count; i++) {
+        err = api->send(&s, &txdata[i * write_len], write_len);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            break;
+        }
+    }
+    TEST_EQ(((sock_data_s *) s.impl)->tx_coalesce_len, tx_total);
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_TIMEOUT / 2);
+    while (!timedout) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(connect_tx_done, false);
+
+    // uncork sends held data as one segment
+    cork = 0;
+    err = api->set_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_CORK, &cork, sizeof(cork));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(((sock_data_s *) s.impl)->tx_coalesce_len, 0);
+
+    timedout = 0;
+    to.attach(onTimeout, 4 * SOCKET_TEST_TIMEOUT);
+    while (!timedout && rx_total < tx_total) {
+        size_t len = tx_total - rx_total;
+        err = api->recv(&s, &rxdata[rx_total], &len);
+        if (err == SOCKET_ERROR_NONE) {
+            rx_total += len;
+        } else if (err != SOCKET_ERROR_WOULD_BLOCK) {
+            break;
+        }
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(connect_tx_done, true);
+    TEST_EQ(rx_total, tx_total);
+    TEST_EQ(memcmp(txdata, rxdata, rx_total), 0);
+
+    // gathered write is held while corked as well
+    cork = 1;
+    err = api->set_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_CORK, &cork, sizeof(cork));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    connect_tx_done = false;
+    iov[0].base = txdata;
+    iov[0].len = write_len;
+    iov[1].base = &txdata[write_len];
+    iov[1].len = tx_total - write_len;
+    err = api_ext->sendv(&s, iov, 2);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(((sock_data_s *) s.impl)->tx_coalesce_len, tx_total);
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_TIMEOUT / 2);
+    while (!timedout) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(connect_tx_done, false);
+
+    cork = 0;
+    err = api->set_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_CORK, &cork, sizeof(cork));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(((sock_data_s *) s.impl)->tx_coalesce_len, 0);
+
+    rx_total = 0;
+    memset(rxdata, 0, tx_total);
+    timedout = 0;
+    to.attach(onTimeout, 4 * SOCKET_TEST_TIMEOUT);
+    while (!timedout && rx_total < tx_total) {
+        size_t len = tx_total - rx_total;
+        err = api->recv(&s, &rxdata[rx_total], &len);
+        if (err == SOCKET_ERROR_NONE) {
+            rx_total += len;
+        } else if (err != SOCKET_ERROR_WOULD_BLOCK) {
+            break;
+        }
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(connect_tx_done, true);
+    TEST_EQ(rx_total, tx_total);
+    TEST_EQ(memcmp(txdata, rxdata, rx_total), 0);
+
+    // close sends corked data instead of dropping it
+    cork = 1;
+    err = api->set_option(&s, SOCKET_PROTO_LEVEL_TCP, NS_SAL_OPT_CORK, &cork, sizeof(cork));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    connect_tx_done = false;
+    err = api->send(&s, txdata, write_len);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(((sock_data_s *) s.impl)->tx_coalesce_len, write_len);
+
+    err = api->close(&s);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(((sock_data_s *) s.impl)->tx_coalesce_len, 0);
+
+    timedout = 0;
+    to.attach(onTimeout, SOCKET_TEST_TIMEOUT);
+    while (!timedout && !connect_tx_done) {
+        run_cb();
+    }
+    to.detach();
+    TEST_EQ(connect_tx_done, true);
+
+test_destroy:
+    // Tell the host to kill the server
+    TEST_PRINT(">>> KILL ES\r\n");
+    err = api->destroy(&s);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+test_exit:
+    free(txdata);
+    free(rxdata);
+    TEST_RETURN();
+}
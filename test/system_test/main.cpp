@@ -45,6 +45,7 @@ using mbed::util::FunctionPointer0;
 
 #define MAX_NUM_OF_SOCKETS  16      // NanoStack supports max 16 sockets, 2 are already reserved by stack.
 #define STRESS_TESTS_LOOP_COUNT 100 // Stress test loop count
+#define PERF_TEST_RX_QUEUE_DEPTH 1024 // Max receive queue depth in performance tests
 
 #define NS_MAX_UDP_PACKET_SIZE 2047
 #define NS_MAX_TCP_PACKET_SIZE 4096
@@ -265,9 +266,52 @@ int runTest(int testID)
                 true, TEST_SERVER, TEST_PORT, mesh_process_events, NS_MAX_UDP_PACKET_SIZE);
         tests_pass = tests_pass && rc;
         break;
+    case 9:
+        rc = ns_tcp_test_slow_reader(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TCP_PORT, mesh_process_events, 256, 4);
+        tests_pass = tests_pass && rc;
+        break;
+    case 10:
+        rc = ns_udp_test_sendv_echo(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_PORT, mesh_process_events);
+        tests_pass = tests_pass && rc;
+        break;
+    case 11:
+        rc = ns_udp_test_tx_queue(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_PORT, mesh_process_events, 8);
+        tests_pass = tests_pass && rc;
+        break;
+    case 12:
+        rc = ns_tcp_test_cork(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TCP_PORT, mesh_process_events, 8, 6);
+        tests_pass = tests_pass && rc;
+        break;
+    case 13:
+        rc = ns_udp_test_send_buffer(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_PORT, mesh_process_events, 8);
+        tests_pass = tests_pass && rc;
+        break;
+    case 14:
+        rc = ns_udp_test_pacing(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_PORT, mesh_process_events, 320, 64, 8);
+        tests_pass = tests_pass && rc;
+        break;
+    case 15:
+        rc = ns_udp_test_rx_direct(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_PORT, mesh_process_events);
+        tests_pass = tests_pass && rc;
+        break;
+    case 16:
+        rc = ns_udp_test_send_batch_order(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_NO_SRV_PORT,
+                                          mesh_process_events);
+        tests_pass = tests_pass && rc;
+        break;
+    case 17:
+        rc = ns_udp_test_priority_close(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_NO_SRV_PORT,
+                                        mesh_process_events);
+        tests_pass = tests_pass && rc;
+        break;
+    case 18:
+        rc = ns_udp_test_pacing_timer(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_NO_SRV_PORT,
+                                      mesh_process_events);
+        tests_pass = tests_pass && rc;
+        break;
 #if 0
         //NO response received to connection refusal (RST)! skip the test and fix this when fixing TCP socket
-    case 9:
+    case 19:
         rc = ns_socket_test_connect_failure(SOCKET_STACK_NANOSTACK_IPV6, SOCKET_AF_INET6, SOCKET_STREAM,
                 TEST_SERVER, TEST_NO_SRV_PORT, mesh_process_events);
         tests_pass = tests_pass && rc;
@@ -334,6 +378,33 @@ int runAPITest(int testID)
     rc = ns_socket_test_unimplemented_apis(SOCKET_STACK_NANOSTACK_IPV6);
     tests_pass = tests_pass && rc;
 
+    rc = ns_socket_test_rcvbuf_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_rcvbuf_stream_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_recv_borrow_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_rx_coalesce_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_rx_peek_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_rx_overrun_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_sendv_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_sndspace_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_handle_api(SOCKET_STACK_NANOSTACK_IPV6);
+    tests_pass = tests_pass && rc;
+
     return -1; // no more tests to run in this set
 }
 
@@ -364,6 +435,40 @@ int runStressTest(int testID)
     rc = ns_socket_test_udp_traffic(SOCKET_STACK_NANOSTACK_IPV6, SOCKET_AF_INET6, SOCKET_DGRAM,
             TEST_SERVER, TEST_PORT, mesh_process_events, STRESS_TESTS_LOOP_COUNT, 10);
     tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_rx_queue_perf(PERF_TEST_RX_QUEUE_DEPTH);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_stream_partial_read_perf(SOCKET_STACK_NANOSTACK_IPV6, 1024, 4);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_rx_pool_stress(STRESS_TESTS_LOOP_COUNT, 4);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_recv_batch_perf(SOCKET_STACK_NANOSTACK_IPV6, 16, 40, STRESS_TESTS_LOOP_COUNT);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_rx_notify_perf(SOCKET_STACK_NANOSTACK_IPV6, 100);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_send_batch_perf(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_NO_SRV_PORT,
+                                        mesh_process_events, 8, 40, 10);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_create_destroy_perf(SOCKET_STACK_NANOSTACK_IPV6, SOCKET_DGRAM, 20, STRESS_TESTS_LOOP_COUNT);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_priority_latency(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_NO_SRV_PORT,
+                                         mesh_process_events, 100, 10);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_event_queue_latency(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_NO_SRV_PORT,
+                                            mesh_process_events, 20, 2000);
+    tests_pass = tests_pass && rc;
+
+    rc = ns_socket_test_event_mask_perf(SOCKET_STACK_NANOSTACK_IPV6, TEST_SERVER, TEST_NO_SRV_PORT,
+                                        mesh_process_events, 20);
+    tests_pass = tests_pass && rc;
     enable_detailed_tracing(true);
 
     return -1;
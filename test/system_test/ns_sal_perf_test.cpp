@@ -0,0 +1,868 @@
+/*
+ * Copyright (c) 2015 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * NanoStack Socket Abstraction Layer (ns_sal) performance tests.
+ * These tests exercise ns_sal internals directly and print measured figures
+ * to the test trace so that results can be compared between builds.
+ */
+
+#include "sal/socket_api.h"
+#include "sal/test/ctest_env.h"
+#include "mbed-drivers/mbed.h"
+#include "mbed-drivers/Timer.h"
+#include "ns_address.h"
+#include "sal-iface-6lowpan/ns_sal.h"
+#include "sal-iface-6lowpan/ns_sal_buffer.h"
+#include "sal-iface-6lowpan/ns_wrapper.h"
+extern "C" {
+#include "sal-iface-6lowpan/ns_sal_callback.h"
+}
+#include "test_cases.h"
+
+#define PERF_TEST_LOOPS 1000
+
+static volatile int perf_test_cb_count;
+static void perf_test_socket_cb(void)
+{
+    perf_test_cb_count++;
+}
+
+/*
+ * Queue datagrams to socket as if they were received from the stack
+ */
+static void perf_test_inject_datagrams(struct socket *sock, uint16_t count, uint16_t length)
+{
+    uint16_t i;
+    for (i = 0; i < count; i++) {
+        data_buff_t *data_buf = ns_sal_rx_buffer_alloc(length);
+        if (!TEST_NEQ(data_buf, NULL)) {
+            return;
+        }
+        memset(&data_buf->ns_address, 0, sizeof(data_buf->ns_address));
+        data_buf->length = length;
+        data_buf->offset = 0;
+        memset(data_buf->payload, (uint8_t) i, length);
+        ns_sal_callback_data_received(sock, data_buf);
+    }
+}
+
+/*
+ * Measure time spent for enqueue/dequeue pair when queue holds given number of buffers.
+ */
+static int rx_queue_enqueue_cost_us(data_buff_t *buf_tbl, uint16_t depth)
+{
+    rx_queue_t queue;
+    mbed::Timer timer;
+    int i;
+
+    ns_sal_rx_queue_init(&queue);
+    for (i = 0; i < depth; i++) {
+        ns_sal_rx_queue_enqueue(&queue, &buf_tbl[i]);
+    }
+
+    timer.start();
+    for (i = 0; i < PERF_TEST_LOOPS; i++) {
+        ns_sal_rx_queue_enqueue(&queue, ns_sal_rx_queue_dequeue(&queue));
+    }
+    timer.stop();
+
+    TEST_EQ(queue.count, depth);
+    // buffers are not owned by the queue, leave them to caller
+    ns_sal_rx_queue_init(&queue);
+    return timer.read_us();
+}
+
+int ns_socket_test_rx_queue_perf(uint16_t max_depth)
+{
+    static const uint16_t depth_tbl[] = {1, 64, 1024};
+    int cost_tbl[sizeof(depth_tbl) / sizeof(depth_tbl[0])];
+    unsigned i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s max_depth: %d\r\n", __func__, (int) max_depth);
+
+    data_buff_t *buf_tbl = (data_buff_t *)malloc(max_depth * sizeof(data_buff_t));
+    if (!TEST_NEQ(buf_tbl, NULL)) {
+        TEST_RETURN();
+    }
+
+    for (i = 0; i < sizeof(depth_tbl) / sizeof(depth_tbl[0]); i++) {
+        if (depth_tbl[i] > max_depth) {
+            cost_tbl[i] = cost_tbl[i - 1];
+            continue;
+        }
+        cost_tbl[i] = rx_queue_enqueue_cost_us(buf_tbl, depth_tbl[i]);
+        TEST_PRINT("rx queue depth %d: %d us / %d enqueues\r\n", depth_tbl[i], cost_tbl[i], PERF_TEST_LOOPS);
+    }
+
+    // enqueue cost must not depend on queue depth, allow some jitter
+    TEST_EQ(cost_tbl[2] <= 2 * cost_tbl[0] + 10, true);
+
+    free(buf_tbl);
+    TEST_RETURN();
+}
+
+int ns_socket_test_stream_partial_read_perf(socket_stack_t stack, uint16_t segment_len, uint16_t read_len)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    mbed::Timer timer;
+    uint16_t i;
+    size_t rx_total = 0;
+    int reads = 0;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s segment: %d, read: %d\r\n", __func__, (int) segment_len, (int) read_len);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    uint8_t *rxdata = (uint8_t *)malloc(read_len);
+    if (!TEST_NEQ(rxdata, NULL)) {
+        TEST_RETURN();
+    }
+
+    sock.impl = NULL;
+    err = api->create(&sock, SOCKET_AF_INET6, SOCKET_STREAM, &perf_test_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        free(rxdata);
+        TEST_RETURN();
+    }
+
+    // Queue one segment as if it was received from the stack
+    data_buff_t *data_buf = ns_sal_rx_buffer_alloc(segment_len);
+    if (!TEST_NEQ(data_buf, NULL)) {
+        TEST_EXIT();
+    }
+    memset(&data_buf->ns_address, 0, sizeof(data_buf->ns_address));
+    data_buf->length = segment_len;
+    data_buf->offset = 0;
+    for (i = 0; i < segment_len; i++) {
+        data_buf->payload[i] = (uint8_t) i;
+    }
+    ns_sal_callback_data_received(&sock, data_buf);
+
+    // Read the segment in small chunks like protocol parsers do
+    timer.start();
+    while (rx_total < segment_len) {
+        size_t len = read_len;
+        err = api->recv(&sock, rxdata, &len);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            break;
+        }
+        for (i = 0; i < len; i++) {
+            if (rxdata[i] != (uint8_t)(rx_total + i)) {
+                TEST_EQ(rxdata[i], (uint8_t)(rx_total + i));
+                break;
+            }
+        }
+        rx_total += len;
+        reads++;
+    }
+    timer.stop();
+
+    TEST_EQ(rx_total, segment_len);
+    TEST_PRINT("%d reads of %d bytes: %d us\r\n", reads, (int) read_len, timer.read_us());
+
+test_exit:
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    free(rxdata);
+    TEST_RETURN();
+}
+
+int ns_socket_test_rx_pool_stress(uint16_t loops, uint8_t max_buffers)
+{
+    rx_pool_stats_t stats_start;
+    rx_pool_stats_t stats_end;
+    data_buff_t *buf_tbl[max_buffers];
+    static const uint16_t size_tbl[] = {16, 100, 128, 300, 512, 1000, 1280};
+    uint16_t loop;
+    uint8_t i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s loops: %d, buffers: %d\r\n", __func__, (int) loops, (int) max_buffers);
+
+    memset(buf_tbl, 0, sizeof(buf_tbl));
+    ns_sal_rx_pool_stats_get(&stats_start);
+
+    // allocate and free buffers of different sizes in mixed order
+    for (loop = 0; loop < loops; loop++) {
+        for (i = 0; i < max_buffers; i++) {
+            uint8_t slot = (uint8_t)((i * 7 + loop) % max_buffers);
+            if (buf_tbl[slot]) {
+                ns_sal_rx_buffer_free(buf_tbl[slot]);
+                buf_tbl[slot] = NULL;
+            } else {
+                uint16_t size = size_tbl[(loop + i) % (sizeof(size_tbl) / sizeof(size_tbl[0]))];
+                buf_tbl[slot] = ns_sal_rx_buffer_alloc(size);
+                if (!TEST_NEQ(buf_tbl[slot], NULL)) {
+                    break;
+                }
+                memset(buf_tbl[slot]->payload, 0xa5, size);
+            }
+        }
+    }
+
+    for (i = 0; i < max_buffers; i++) {
+        if (buf_tbl[i]) {
+            ns_sal_rx_buffer_free(buf_tbl[i]);
+        }
+    }
+
+    ns_sal_rx_pool_stats_get(&stats_end);
+    TEST_PRINT("pool allocs: %lu, frees: %lu, heap fallbacks: %lu, failures: %lu\r\n",
+               stats_end.alloc_count - stats_start.alloc_count,
+               stats_end.free_count - stats_start.free_count,
+               stats_end.fallback_count - stats_start.fallback_count,
+               stats_end.fail_count - stats_start.fail_count);
+
+    // all buffers returned to pool and heap was not touched
+    TEST_EQ(stats_end.alloc_count - stats_start.alloc_count, stats_end.free_count - stats_start.free_count);
+    TEST_EQ(stats_end.fallback_count, stats_start.fallback_count);
+    TEST_EQ(stats_end.fail_count, stats_start.fail_count);
+
+    TEST_RETURN();
+}
+
+int ns_socket_test_recv_batch_perf(socket_stack_t stack, uint16_t dgram_count, uint16_t dgram_len, uint16_t loops)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    mbed::Timer timer_loop;
+    mbed::Timer timer_batch;
+    struct ns_sal_datagram dgrams[dgram_count];
+    uint16_t loop;
+    uint16_t i;
+    size_t count;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s datagrams: %d, length: %d\r\n", __func__, (int) dgram_count, (int) dgram_len);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    uint8_t *rxdata = (uint8_t *)malloc(dgram_count * dgram_len);
+    if (!TEST_NEQ(rxdata, NULL)) {
+        TEST_RETURN();
+    }
+
+    sock.impl = NULL;
+    err = api->create(&sock, SOCKET_AF_INET6, SOCKET_DGRAM, &perf_test_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        free(rxdata);
+        TEST_RETURN();
+    }
+
+    for (loop = 0; loop < loops; loop++) {
+        // drain with recv_from loop
+        perf_test_inject_datagrams(&sock, dgram_count, dgram_len);
+        timer_loop.start();
+        for (i = 0; i < dgram_count; i++) {
+            size_t len = dgram_len;
+            err = api->recv_from(&sock, &rxdata[i * dgram_len], &len, &dgrams[i].addr, &dgrams[i].port);
+            if (err != SOCKET_ERROR_NONE) {
+                break;
+            }
+        }
+        timer_loop.stop();
+        TEST_EQ(i, dgram_count);
+
+        // drain with one batch call
+        perf_test_inject_datagrams(&sock, dgram_count, dgram_len);
+        for (i = 0; i < dgram_count; i++) {
+            dgrams[i].buf = &rxdata[i * dgram_len];
+            dgrams[i].len = dgram_len;
+        }
+        count = dgram_count;
+        timer_batch.start();
+        err = nanostack_socket_api_ext.recv_from_batch(&sock, dgrams, &count);
+        timer_batch.stop();
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        TEST_EQ(count, dgram_count);
+        TEST_EQ(dgrams[dgram_count - 1].len, dgram_len);
+    }
+
+    TEST_PRINT("recv_from loop: %d us, recv_from_batch: %d us for %d datagrams\r\n",
+               timer_loop.read_us(), timer_batch.read_us(), dgram_count * loops);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    free(rxdata);
+    TEST_RETURN();
+}
+
+int ns_socket_test_rx_notify_perf(socket_stack_t stack, uint16_t dgram_count)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    uint8_t buf[16];
+    uint8_t mode;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s datagrams: %d\r\n", __func__, (int) dgram_count);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    sock.impl = NULL;
+    err = api->create(&sock, SOCKET_AF_INET6, SOCKET_DGRAM, &perf_test_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+
+    for (mode = NS_SAL_RX_NOTIFY_ALL; mode <= NS_SAL_RX_NOTIFY_EDGE; mode++) {
+        mbed::Timer timer;
+        size_t len;
+
+        err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_RX_NOTIFY, &mode, sizeof(mode));
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+
+        // burst of datagrams, application reads them after the burst
+        perf_test_cb_count = 0;
+        timer.start();
+        perf_test_inject_datagrams(&sock, dgram_count, sizeof(buf));
+        do {
+            len = sizeof(buf);
+            err = api->recv(&sock, buf, &len);
+        } while (err == SOCKET_ERROR_NONE);
+        timer.stop();
+
+        TEST_PRINT("rx notify mode %d: %d handler calls, %d us\r\n", mode, perf_test_cb_count, timer.read_us());
+        TEST_EQ(perf_test_cb_count, mode == NS_SAL_RX_NOTIFY_ALL ? dgram_count : 1);
+    }
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_RETURN();
+}
+
+static struct socket *send_batch_socket;
+static volatile int send_batch_tx_count;
+static void send_batch_socket_cb(void)
+{
+    switch (send_batch_socket->event->event) {
+        case SOCKET_EVENT_TX_DONE:
+        case SOCKET_EVENT_TX_ERROR:
+            send_batch_tx_count++;
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Wait until NanoStack has reported all sends done
+ */
+static bool send_batch_wait(run_func_t run_cb, int tx_count)
+{
+    mbed::Timer timer;
+    timer.start();
+    while (send_batch_tx_count < tx_count && timer.read_ms() < 1000 * tx_count) {
+        run_cb();
+    }
+    return send_batch_tx_count >= tx_count;
+}
+
+int ns_socket_test_send_batch_perf(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                   uint16_t dgram_count, uint16_t dgram_len, uint16_t loops)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    mbed::Timer timer_loop;
+    mbed::Timer timer_batch;
+    struct ns_sal_datagram dgrams[dgram_count];
+    socket_error_t status[dgram_count];
+    struct socket_addr addr;
+    uint32_t limit;
+    uint16_t loop;
+    uint16_t i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s datagrams: %d, length: %d\r\n", __func__, (int) dgram_count, (int) dgram_len);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    uint8_t *txdata = (uint8_t *)malloc(dgram_len);
+    if (!TEST_NEQ(txdata, NULL)) {
+        TEST_RETURN();
+    }
+    memset(txdata, 'x', dgram_len);
+
+    send_batch_socket = &sock;
+    sock.impl = NULL;
+    err = api->create(&sock, SOCKET_AF_INET6, SOCKET_DGRAM, &send_batch_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        free(txdata);
+        TEST_RETURN();
+    }
+    err = api->str2addr(&sock, &addr, server);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // NanoStack is busy after first datagram, queue the rest in both cases
+    limit = dgram_count * dgram_len;
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    for (i = 0; i < dgram_count; i++) {
+        dgrams[i].buf = txdata;
+        dgrams[i].len = dgram_len;
+        dgrams[i].addr = addr;
+        dgrams[i].port = port;
+    }
+
+    for (loop = 0; loop < loops; loop++) {
+        // send_to loop
+        send_batch_tx_count = 0;
+        timer_loop.start();
+        for (i = 0; i < dgram_count; i++) {
+            err = api->send_to(&sock, txdata, dgram_len, &addr, port);
+            if (err != SOCKET_ERROR_NONE) {
+                break;
+            }
+        }
+        timer_loop.stop();
+        TEST_EQ(i, dgram_count);
+        if (!TEST_EQ(send_batch_wait(run_cb, i), true)) {
+            break;
+        }
+
+        // one batch call
+        send_batch_tx_count = 0;
+        timer_batch.start();
+        err = nanostack_socket_api_ext.send_to_batch(&sock, dgrams, status, dgram_count);
+        timer_batch.stop();
+        TEST_EQ(err, SOCKET_ERROR_NONE);
+        TEST_EQ(status[dgram_count - 1], SOCKET_ERROR_NONE);
+        if (!TEST_EQ(send_batch_wait(run_cb, dgram_count), true)) {
+            break;
+        }
+    }
+
+    TEST_PRINT("send_to loop: %d us, send_to_batch: %d us for %d datagrams\r\n",
+               timer_loop.read_us(), timer_batch.read_us(), dgram_count * loops);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    free(txdata);
+    TEST_RETURN();
+}
+
+static struct socket *priority_bulk_socket;
+static struct socket *priority_alarm_socket;
+static volatile int priority_bulk_tx_count;
+static volatile bool priority_alarm_tx_done;
+static void priority_bulk_socket_cb(void)
+{
+    switch (priority_bulk_socket->event->event) {
+        case SOCKET_EVENT_TX_DONE:
+        case SOCKET_EVENT_TX_ERROR:
+            priority_bulk_tx_count++;
+            break;
+        default:
+            break;
+    }
+}
+
+static void priority_alarm_socket_cb(void)
+{
+    switch (priority_alarm_socket->event->event) {
+        case SOCKET_EVENT_TX_DONE:
+        case SOCKET_EVENT_TX_ERROR:
+            priority_alarm_tx_done = true;
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Send alarms while bulk socket keeps its transmit queue full.
+ * Return average time from alarm send to alarm TX_DONE, 0 on failure.
+ */
+static int priority_alarm_latency(const struct socket_api *api, run_func_t run_cb, struct socket *bulk,
+                                  struct socket *alarm, const struct socket_addr *addr, uint16_t port,
+                                  uint8_t *txdata, uint16_t bulk_len, uint16_t alarms)
+{
+    mbed::Timer timer;
+    mbed::Timer timeout;
+    int latency_us = 0;
+    uint16_t i;
+
+    for (i = 0; i < alarms; i++) {
+        // saturate bulk queue, send_to fails when queue is full
+        while (SOCKET_ERROR_NONE == api->send_to(bulk, txdata, bulk_len, addr, port));
+
+        priority_alarm_tx_done = false;
+        timer.reset();
+        timer.start();
+        if (!TEST_EQ(api->send_to(alarm, txdata, 8, addr, port), SOCKET_ERROR_NONE)) {
+            return 0;
+        }
+        timeout.reset();
+        timeout.start();
+        while (!priority_alarm_tx_done && timeout.read_ms() < 5000) {
+            run_cb();
+            // keep bulk queue full
+            api->send_to(bulk, txdata, bulk_len, addr, port);
+        }
+        timer.stop();
+        if (!TEST_EQ(priority_alarm_tx_done, true)) {
+            return 0;
+        }
+        latency_us += timer.read_us();
+    }
+
+    // let bulk queue drain before next round
+    timeout.reset();
+    timeout.start();
+    while (timeout.read_ms() < 2000) {
+        run_cb();
+    }
+    return latency_us / alarms;
+}
+
+int ns_socket_test_priority_latency(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                    uint16_t bulk_len, uint16_t alarms)
+{
+    struct socket bulk;
+    struct socket alarm;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    struct socket_addr addr;
+    uint32_t limit;
+    uint8_t priority;
+    uint8_t tclass;
+    int latency_fifo;
+    int latency_prio;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s bulk datagram length: %d, alarms: %d\r\n", __func__, (int) bulk_len, (int) alarms);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    uint8_t *txdata = (uint8_t *)malloc(bulk_len);
+    if (!TEST_NEQ(txdata, NULL)) {
+        TEST_RETURN();
+    }
+    memset(txdata, 'x', bulk_len);
+
+    priority_bulk_socket = &bulk;
+    priority_alarm_socket = &alarm;
+    bulk.impl = NULL;
+    alarm.impl = NULL;
+    err = api->create(&bulk, SOCKET_AF_INET6, SOCKET_DGRAM, &priority_bulk_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        free(txdata);
+        TEST_RETURN();
+    }
+    err = api->create(&alarm, SOCKET_AF_INET6, SOCKET_DGRAM, &priority_alarm_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_EXIT();
+    }
+    err = api->str2addr(&bulk, &addr, server);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    limit = 8 * bulk_len;
+    err = api->set_option(&bulk, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // argument checks
+    priority = NS_SAL_PRIORITY_MAX + 1;
+    err = api->set_option(&alarm, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PRIORITY, &priority, sizeof(priority));
+    TEST_EQ(err, SOCKET_ERROR_BAD_ARGUMENT);
+    err = api->set_option(&alarm, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TCLASS, &tclass, sizeof(uint32_t));
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+
+    // both sockets in same priority, alarm waits behind bulk data in NanoStack
+    latency_fifo = priority_alarm_latency(api, run_cb, &bulk, &alarm, &addr, port, txdata, bulk_len, alarms);
+
+    // alarm with highest priority and expedited forwarding DSCP
+    priority = NS_SAL_PRIORITY_MAX;
+    err = api->set_option(&alarm, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_PRIORITY, &priority, sizeof(priority));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    tclass = 46 << 2;
+    err = api->set_option(&alarm, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TCLASS, &tclass, sizeof(tclass));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    err = api->get_option(&alarm, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_TCLASS, &tclass, sizeof(tclass));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(tclass, 46 << 2);
+    latency_prio = priority_alarm_latency(api, run_cb, &bulk, &alarm, &addr, port, txdata, bulk_len, alarms);
+
+    TEST_PRINT("alarm latency with saturating bulk: same priority %d us, high priority %d us\r\n",
+               latency_fifo, latency_prio);
+    TEST_NEQ(latency_prio, 0);
+    TEST_EQ(latency_prio <= latency_fifo, true);
+
+    err = api->destroy(&alarm);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+test_exit:
+    err = api->destroy(&bulk);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    free(txdata);
+    TEST_RETURN();
+}
+
+int ns_socket_test_create_destroy_perf(socket_stack_t stack, socket_proto_family_t pf, uint8_t max_num_of_sockets,
+                                       uint16_t loops)
+{
+    socket_error_t err = SOCKET_ERROR_NONE;
+    const struct socket_api *api = socket_get_api(stack);
+    mbed::Timer timer_create;
+    mbed::Timer timer_destroy;
+    struct socket sock_tbl[max_num_of_sockets];
+    int socket_nbr = 0;
+    int total = 0;
+    uint16_t loop;
+    int i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s pf: %d, sockets: %d, loops: %d\r\n", __func__, (int) pf, (int) max_num_of_sockets, (int) loops);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    for (loop = 0; loop < loops; loop++) {
+        // create sockets until creation fails, like ns_socket_test_max_num_of_sockets
+        timer_create.start();
+        for (i = 0; i < max_num_of_sockets; i++) {
+            sock_tbl[i].impl = NULL;
+            err = api->create(&sock_tbl[i], SOCKET_AF_INET6, pf, &perf_test_socket_cb);
+            if (err != SOCKET_ERROR_NONE) {
+                break;
+            }
+        }
+        timer_create.stop();
+        if (0 == loop) {
+            socket_nbr = i;
+        } else if (!TEST_EQ(i, socket_nbr)) {
+            // sockets leaked or lost between rounds
+            TEST_PRINT("round %d created %d sockets, first round %d\r\n", loop, i, socket_nbr);
+        }
+        total += i;
+
+        timer_destroy.start();
+        while (i > 0) {
+            err = api->destroy(&sock_tbl[--i]);
+            TEST_EQ(err, SOCKET_ERROR_NONE);
+        }
+        timer_destroy.stop();
+    }
+
+    TEST_NEQ(total, 0);
+    if (total > 0) {
+        TEST_PRINT("%d sockets per round, create %d us, destroy %d us per socket\r\n", socket_nbr,
+                   timer_create.read_us() / total, timer_destroy.read_us() / total);
+    }
+    TEST_RETURN();
+}
+
+static struct socket *event_queue_socket;
+static volatile int event_queue_tx_count;
+static uint16_t event_queue_handler_us;
+static void event_queue_socket_cb(void)
+{
+    switch (event_queue_socket->event->event) {
+        case SOCKET_EVENT_TX_DONE:
+        case SOCKET_EVENT_TX_ERROR: {
+            // simulate slow application handler
+            mbed::Timer timer;
+            timer.start();
+            while (timer.read_us() < event_queue_handler_us);
+            event_queue_tx_count++;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int ns_socket_test_event_queue_latency(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                       uint16_t dgram_count, uint16_t handler_us)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    ns_wrapper_event_stats_t stats;
+    struct socket_addr addr;
+    mbed::Timer timeout;
+    uint8_t txdata[16];
+    uint16_t i;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s datagrams: %d, handler: %d us\r\n", __func__, (int) dgram_count, (int) handler_us);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    memset(txdata, 'x', sizeof(txdata));
+    event_queue_socket = &sock;
+    event_queue_handler_us = handler_us;
+    sock.impl = NULL;
+    err = api->create(&sock, SOCKET_AF_INET6, SOCKET_DGRAM, &event_queue_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+    err = api->str2addr(&sock, &addr, server);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    ns_wrapper_event_stats_reset();
+    for (i = 0; i < dgram_count; i++) {
+        event_queue_tx_count = 0;
+        err = api->send_to(&sock, txdata, sizeof(txdata), &addr, port);
+        if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+            break;
+        }
+        timeout.reset();
+        timeout.start();
+        while (0 == event_queue_tx_count && timeout.read_ms() < 5000) {
+            run_cb();
+        }
+        if (!TEST_EQ(event_queue_tx_count, 1)) {
+            break;
+        }
+    }
+    ns_wrapper_event_stats_get(&stats);
+
+    if (0 == stats.queued) {
+        TEST_PRINT("event queue disabled, handlers called from NanoStack callback\r\n");
+    } else {
+        // every queued event is delivered, none were lost
+        TEST_EQ(stats.dispatched + stats.stale, stats.queued);
+        TEST_EQ(stats.handler_max >= handler_us, true);
+        TEST_PRINT("events: %d, passes: %d, depth max: %d, overflow: %d, stale: %d\r\n",
+                   (int) stats.queued, (int) stats.passes, (int) stats.depth_max, (int) stats.overflow,
+                   (int) stats.stale);
+        TEST_PRINT("queue latency max: %d us, handler max: %d us\r\n",
+                   (int) stats.latency_max, (int) stats.handler_max);
+    }
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_RETURN();
+}
+
+static volatile int event_mask_cb_count;
+static void event_mask_socket_cb(void)
+{
+    event_mask_cb_count++;
+}
+
+/*
+ * Send datagrams and wait until all are sent, return number of handler calls.
+ * Sent data is polled with NS_SAL_OPT_SNDSPACE as TX_DONE may not be delivered.
+ */
+static int event_mask_send(const struct socket_api *api, run_func_t run_cb, struct socket *sock,
+                           const struct socket_addr *addr, uint16_t port, uint8_t *txdata, uint16_t dgram_count)
+{
+    struct ns_sal_tx_space space;
+    mbed::Timer timeout;
+    uint16_t i;
+
+    event_mask_cb_count = 0;
+    for (i = 0; i < dgram_count; i++) {
+        if (!TEST_EQ(api->send_to(sock, txdata, 16, addr, port), SOCKET_ERROR_NONE)) {
+            return -1;
+        }
+    }
+    timeout.start();
+    do {
+        run_cb();
+        api->get_option(sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDSPACE, &space, sizeof(space));
+    } while ((space.in_flight > 0 || space.queued > 0) && timeout.read_ms() < 1000 * dgram_count);
+    TEST_EQ(space.in_flight + space.queued, 0);
+    return event_mask_cb_count;
+}
+
+int ns_socket_test_event_mask_perf(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                   uint16_t dgram_count)
+{
+    struct socket sock;
+    socket_error_t err;
+    const struct socket_api *api = socket_get_api(stack);
+    struct socket_addr addr;
+    uint8_t txdata[16];
+    uint32_t limit;
+    uint32_t mask;
+    int calls_all;
+    int calls_errors;
+
+    TEST_CLEAR();
+    TEST_PRINT("\r\n%s datagrams: %d\r\n", __func__, (int) dgram_count);
+
+    if (!TEST_NEQ(api, NULL)) {
+        // Test cannot continue without API.
+        TEST_RETURN();
+    }
+
+    memset(txdata, 'x', sizeof(txdata));
+    sock.impl = NULL;
+    err = api->create(&sock, SOCKET_AF_INET6, SOCKET_DGRAM, &event_mask_socket_cb);
+    if (!TEST_EQ(err, SOCKET_ERROR_NONE)) {
+        TEST_RETURN();
+    }
+    err = api->str2addr(&sock, &addr, server);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    limit = dgram_count * sizeof(txdata);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_SNDQUEUE, &limit, sizeof(limit));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+
+    // all events are delivered by default
+    err = api->get_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_EVENT_MASK, &mask, sizeof(mask));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_EQ(mask, NS_SAL_EVENT_MASK_ALL);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_EVENT_MASK, &mask, sizeof(uint8_t));
+    TEST_EQ(err, SOCKET_ERROR_SIZE);
+
+    calls_all = event_mask_send(api, run_cb, &sock, &addr, port, txdata, dgram_count);
+
+    // fire-and-forget sender, only errors are delivered
+    mask = NS_SAL_EVENT_BIT(SOCKET_EVENT_ERROR) | NS_SAL_EVENT_BIT(SOCKET_EVENT_TX_ERROR) |
+           NS_SAL_EVENT_BIT(SOCKET_EVENT_RX_ERROR);
+    err = api->set_option(&sock, SOCKET_PROTO_LEVEL_UDP, NS_SAL_OPT_EVENT_MASK, &mask, sizeof(mask));
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    calls_errors = event_mask_send(api, run_cb, &sock, &addr, port, txdata, dgram_count);
+
+    TEST_PRINT("handler calls for %d datagrams: all events %d, errors only %d\r\n",
+               (int) dgram_count, calls_all, calls_errors);
+    TEST_EQ(calls_all >= dgram_count, true);
+    TEST_EQ(calls_errors < calls_all, true);
+
+    err = api->destroy(&sock);
+    TEST_EQ(err, SOCKET_ERROR_NONE);
+    TEST_RETURN();
+}
@@ -40,6 +40,13 @@ int socket_api_test_echo_server_stream(socket_stack_t stack, socket_address_fami
  */
 int ns_tcp_bind_and_remote_end_close(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb, uint16_t source_port);
 
+/*
+ * \brief Test TCP reader that doesn't read received data immediately.
+ * Received data is left to NanoStack and SAL receive buffers must not be allocated.
+ */
+int ns_tcp_test_slow_reader(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                            uint16_t block_size, uint8_t block_count);
+
 /*
  * \brief Test UDP received data buffering. Four datagrams buffered and client starts reading when 5th datagram arrives.
  *  -first datagram is read completely,
@@ -130,6 +137,167 @@ int ns_socket_test_close_api(socket_stack_t stack, socket_proto_family_t pf);
   */
 int ns_socket_test_unimplemented_apis(socket_stack_t stack);
 
+/*
+ * \brief Test receive queue limit options and drop policies
+  */
+int ns_socket_test_rcvbuf_api(socket_stack_t stack);
+
+/*
+ * \brief Test that receive queue limit leaves stream data to NanoStack instead of dropping it
+  */
+int ns_socket_test_rcvbuf_stream_api(socket_stack_t stack);
+
+/*
+ * \brief Test zero-copy receive API
+  */
+int ns_socket_test_recv_borrow_api(socket_stack_t stack);
+
+/*
+ * \brief Test appending stream data to the last receive buffer
+  */
+int ns_socket_test_rx_coalesce_api(socket_stack_t stack);
+
+/*
+ * \brief Test receive queue query and peek options
+  */
+int ns_socket_test_rx_peek_api(socket_stack_t stack);
+
+/*
+ * \brief Test receive overrun event and counter
+  */
+int ns_socket_test_rx_overrun_api(socket_stack_t stack);
+
+/*
+ * \brief Test scatter/gather send argument checks
+  */
+int ns_socket_test_sendv_api(socket_stack_t stack);
+
+/*
+ * \brief Test send buffer size and free space options
+  */
+int ns_socket_test_sndspace_api(socket_stack_t stack);
+
+/*
+ * \brief Test socket handle is invalidated when socket is destroyed and socket ID is reused
+  */
+int ns_socket_test_handle_api(socket_stack_t stack);
+
+/*
+ * \brief Send header, body and trailer with sendv_to() and check echoed datagram
+ */
+int ns_udp_test_sendv_echo(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb);
+
+/*
+ * \brief Read echoed datagrams directly from NanoStack with recv, recv_from and
+ * recv_from_batch in NS_SAL_OPT_RX_DIRECT mode, including a truncated datagram
+ */
+int ns_udp_test_rx_direct(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb);
+
+/*
+ * \brief Send a burst of datagrams through transmit queue and print queue statistics
+ */
+int ns_udp_test_tx_queue(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                         uint16_t burst);
+
+/*
+ * \brief Send a batch where a rejected datagram is followed by one that gets
+ * SOCKET_ERROR_BUSY, and check later datagrams are not sent ahead of it
+ */
+int ns_udp_test_send_batch_order(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb);
+
+/*
+ * \brief Close and destroy a high priority socket while its datagram is in flight,
+ * and check a datagram held in a lower priority socket is released
+ */
+int ns_udp_test_priority_close(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb);
+
+/*
+ * \brief Send datagrams with transmit pacing and check sending takes at least the time rate allows
+ */
+int ns_udp_test_pacing(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                       uint32_t rate, uint32_t burst, uint8_t count);
+
+/*
+ * \brief Enable pacing after socket open and check a datagram held after the last
+ * TX_DONE is released by the transmit timer
+ */
+int ns_udp_test_pacing_timer(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb);
+
+/*
+ * \brief Send datagrams from socket owned buffers and check buffers are returned in send order
+ */
+int ns_udp_test_send_buffer(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                            uint8_t count);
+
+/*
+ * \brief Write small blocks to corked TCP socket and check they are sent together on uncork
+ */
+int ns_tcp_test_cork(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                     uint16_t write_len, uint8_t write_count);
+
+/* NanoStack SAL performance tests */
+
+/*
+ * \brief Measure receive queue enqueue cost with queue depths 1, 64 and 1024.
+ * Enqueue cost must stay flat regardless of queue depth.
+ */
+int ns_socket_test_rx_queue_perf(uint16_t max_depth);
+
+/*
+ * \brief Measure time to read a stream segment with small reads.
+ * Partial reads must not move unread data within the receive buffer.
+ */
+int ns_socket_test_stream_partial_read_perf(socket_stack_t stack, uint16_t segment_len, uint16_t read_len);
+
+/*
+ * \brief Allocate and free receive buffers of mixed sizes.
+ * Heap must not be used as long as number of buffers in use fits to the pool.
+ */
+int ns_socket_test_rx_pool_stress(uint16_t loops, uint8_t max_buffers);
+
+/*
+ * \brief Compare datagram receive time of recv_from loop and recv_from_batch.
+ */
+int ns_socket_test_recv_batch_perf(socket_stack_t stack, uint16_t dgram_count, uint16_t dgram_len, uint16_t loops);
+
+/*
+ * \brief Compare handler calls and time for a datagram burst in both RX notify modes.
+ */
+int ns_socket_test_rx_notify_perf(socket_stack_t stack, uint16_t dgram_count);
+
+/*
+ * \brief Compare time spent in send_to() loop and send_to_batch() for same datagrams.
+ */
+int ns_socket_test_send_batch_perf(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                   uint16_t dgram_count, uint16_t dgram_len, uint16_t loops);
+
+/*
+ * \brief Create sockets until creation fails and destroy them, repeatedly.
+ * Print create and destroy time per socket and check no socket is lost between rounds.
+ */
+int ns_socket_test_create_destroy_perf(socket_stack_t stack, socket_proto_family_t pf, uint8_t max_num_of_sockets,
+                                       uint16_t loops);
+
+/*
+ * \brief Measure alarm datagram latency while a bulk socket saturates the transmit queue,
+ * with alarm socket in same and in highest transmit priority.
+ */
+int ns_socket_test_priority_latency(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                    uint16_t bulk_len, uint16_t alarms);
+
+/*
+ * \brief Send datagrams one at a time with a slow TX_DONE handler.
+ * Print deferred event dispatch statistics when event queue is enabled.
+ */
+int ns_socket_test_event_queue_latency(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                       uint16_t dgram_count, uint16_t handler_us);
+
+/*
+ * \brief Send datagrams with all events and with only error events subscribed
+ * with NS_SAL_OPT_EVENT_MASK. Print number of socket handler calls.
+ */
+int ns_socket_test_event_mask_perf(socket_stack_t stack, const char *server, uint16_t port, run_func_t run_cb,
+                                   uint16_t dgram_count);
 
 #endif /* __TEST_CASES_H__ */
 